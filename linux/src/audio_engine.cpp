@@ -1,167 +1,390 @@
 #include "audio_engine.h"
-#include <pulse/simple.h>
-#include <pulse/error.h>
-#include <pulse/pulseaudio.h>
+#include "pulse_capture.h"
+#include "simd.h"
+#include "thread_priority.h"
+#ifdef SPEAK_HAVE_PIPEWIRE
+#include "pipewire_capture.h"
+#endif
 #include <cstdio>
 #include <cstring>
 #include <cmath>
 #include <algorithm>
 #include <chrono>
+#include <numeric>
 
 AudioEngine::~AudioEngine() {
     release();
 }
 
-static void source_info_cb(pa_context*, const pa_source_info* info, int eol, void* userdata) {
-    if (eol || !info) return;
-    auto* out = static_cast<std::vector<std::pair<std::string,std::string>>*>(userdata);
-    std::string desc = info->description ? info->description : "";
-    out->push_back({info->name, desc});
+void AudioEngine::list_devices() {
+    PulseCapture::list_sources();
 }
 
-void AudioEngine::list_devices() {
-    pa_mainloop* ml = pa_mainloop_new();
-    pa_context* ctx = pa_context_new(pa_mainloop_get_api(ml), "speak-list");
-    pa_context_connect(ctx, nullptr, PA_CONTEXT_NOFLAGS, nullptr);
-
-    bool ready = false;
-    for (int i = 0; i < 100; ++i) {
-        pa_mainloop_iterate(ml, 0, nullptr);
-        if (pa_context_get_state(ctx) == PA_CONTEXT_READY) { ready = true; break; }
-        if (pa_context_get_state(ctx) == PA_CONTEXT_FAILED) break;
-        struct timespec ts{0, 10000000};
-        nanosleep(&ts, nullptr);
-    }
-
-    if (!ready) {
-        fprintf(stderr, "Cannot connect to PulseAudio/PipeWire\n");
-        pa_context_unref(ctx);
-        pa_mainloop_free(ml);
-        return;
+std::string CapturePath::describe() const {
+    char buf[128];
+    const char* fmt = sample_format_name(spec.format);
+    switch (conversion) {
+    case CaptureConversion::none:
+        std::snprintf(buf, sizeof(buf), "%s %u Hz, direct", fmt, spec.rate);
+        break;
+    case CaptureConversion::format:
+        std::snprintf(buf, sizeof(buf), "%s %u Hz, format conversion only", fmt, spec.rate);
+        break;
+    case CaptureConversion::decimate:
+        std::snprintf(buf, sizeof(buf), "%s %u Hz, %d:1 decimation", fmt, spec.rate, down);
+        break;
+    case CaptureConversion::resample:
+        std::snprintf(buf, sizeof(buf), "%s %u Hz, %d/%d resample", fmt, spec.rate, up, down);
+        break;
+    }
+    return buf;
+}
+
+// Opens the stream in the source's own rate and (if we can read it
+// natively) sample format, so the server does no conversion and we do the
+// least we have to. A source already running at 16 kHz needs no resampling
+// at all. Falls back to float32 at 48 kHz if the server cannot be queried.
+CapturePath AudioEngine::negotiate_path(const std::string& source) const {
+    CapturePath path;
+    if (capture_format == CaptureFormat::native && !PulseCapture::query_source_spec(source, path.spec)) {
+        fprintf(stderr, "[AudioEngine] Could not query source format, using float32 48 kHz\n");
+    }
+    return path;
+}
+
+static void classify_path(CapturePath& path) {
+    int g = static_cast<int>(std::gcd(path.spec.rate, 16000u));
+    path.up = 16000 / g;
+    path.down = static_cast<int>(path.spec.rate) / g;
+
+    if (path.spec.rate == 16000) {
+        path.conversion = path.spec.format == SampleFormat::f32
+            ? CaptureConversion::none : CaptureConversion::format;
+    } else if (path.up == 1) {
+        path.conversion = CaptureConversion::decimate;
+    } else {
+        path.conversion = CaptureConversion::resample;
     }
+}
 
-    std::vector<std::pair<std::string,std::string>> sources;
-    pa_operation* op = pa_context_get_source_info_list(ctx, source_info_cb, &sources);
-    while (pa_operation_get_state(op) == PA_OPERATION_RUNNING) {
-        pa_mainloop_iterate(ml, 0, nullptr);
+std::unique_ptr<CaptureBackend> AudioEngine::create_backend(AudioBackend kind) {
+    switch (kind) {
+    case AudioBackend::pulse_simple:
+        return std::make_unique<PulseSimpleCapture>();
+    case AudioBackend::pipewire:
+#ifdef SPEAK_HAVE_PIPEWIRE
+        return std::make_unique<PipeWireCapture>();
+#else
+        return nullptr;
+#endif
+    case AudioBackend::pulse_stream:
+        break;
     }
-    pa_operation_unref(op);
+    return std::make_unique<PulseStreamCapture>();
+}
+
+const char* AudioEngine::backend_name() const {
+    std::lock_guard<std::mutex> lk(backend_mu_);
+    return backend_ ? backend_->name() : "none";
+}
+
+CaptureStats AudioEngine::capture_stats() const {
+    std::lock_guard<std::mutex> lk(backend_mu_);
+    return backend_ ? backend_->stats() : CaptureStats{};
+}
 
-    for (auto& [name, desc] : sources) {
-        fprintf(stderr, "  %-60s  %s\n", name.c_str(), desc.c_str());
+std::string AudioEngine::capture_scheduling() const {
+    std::lock_guard<std::mutex> lk(sched_mu_);
+    return scheduling_.empty() ? "pending" : scheduling_;
+}
+
+// Runs once on the backend's delivery thread (our read thread, the pulse
+// mainloop or PipeWire's data thread). The scheduler calls cost a few
+// microseconds and only happen on the first callback after prepare().
+void AudioEngine::tune_capture_thread() {
+    std::string sched = realtime ? ThreadPriority::promote_current(rt_priority) : "normal";
+    if (capture_cpu >= 0 && ThreadPriority::pin_current(capture_cpu)) {
+        sched += ", cpu " + std::to_string(capture_cpu);
     }
+    fprintf(stderr, "[AudioEngine] Capture thread: %s\n", sched.c_str());
 
-    pa_context_disconnect(ctx);
-    pa_context_unref(ctx);
-    pa_mainloop_free(ml);
+    std::lock_guard<std::mutex> lk(sched_mu_);
+    scheduling_ = std::move(sched);
 }
 
 void AudioEngine::prepare() {
-    if (pa_) return;
+    // "pipewire" or "pipewire:<node>" picks the native PipeWire backend.
+    AudioBackend kind = backend;
+    std::string source = device;
+    if (device == "pipewire" || device.rfind("pipewire:", 0) == 0) {
+        kind = AudioBackend::pipewire;
+        source = device.size() > 9 ? device.substr(9) : "";
+    }
+
+    auto b = create_backend(kind);
+    if (!b) {
+        fprintf(stderr, "[AudioEngine] PipeWire backend not built in, using pulse-stream\n");
+        b = create_backend(AudioBackend::pulse_stream);
+    }
+    prepare(std::move(b), source);
+}
 
-    pa_sample_spec spec{};
-    spec.format = PA_SAMPLE_FLOAT32LE;
-    spec.channels = 1;
-    spec.rate = 48000;
+void AudioEngine::prepare(std::unique_ptr<CaptureBackend> b, const std::string& source) {
+    std::lock_guard<std::mutex> lk(backend_mu_);
+    if (backend_) return;
 
-    const char* dev = device.empty() ? nullptr : device.c_str();
+    CapturePath path = negotiate_path(source);
+    frame_ms = std::clamp(frame_ms, 10, 100);
 
-    int err = 0;
-    pa_ = pa_simple_new(nullptr, "speak", PA_STREAM_RECORD, dev,
-                         "capture", &spec, nullptr, nullptr, &err);
-    if (!pa_) {
-        fprintf(stderr, "[AudioEngine] pa_simple_new failed: %s\n", pa_strerror(err));
-        if (dev) fprintf(stderr, "[AudioEngine] Device was: %s\n", dev);
+    bool ok = b->open(source, path.spec, frame_ms,
+                      [this](const void* data, size_t frames) { on_frames(data, frames); });
+    if (!ok) {
+        if (!source.empty()) fprintf(stderr, "[AudioEngine] Device was: %s\n", source.c_str());
         fprintf(stderr, "[AudioEngine] Available sources:\n");
         list_devices();
         return;
     }
 
-    hardware_sr_ = spec.rate;
-    running_ = true;
-    capture_thread_ = std::thread(&AudioEngine::capture_loop, this);
-    fprintf(stderr, "[AudioEngine] Engine started (%.0f Hz, device: %s)\n",
-            hardware_sr_, dev ? dev : "default");
+    // The backend reports what it actually opened. Frames are ignored until
+    // running_ is set, so the scratch space can be sized for it here; the
+    // bound is generous so the audio thread never has to grow anything.
+    classify_path(path);
+    size_t max_frames = static_cast<size_t>(path.spec.rate) * 100 / 1000;
+    convert_buf_.assign(max_frames, 0.0f);
+    resampler_.configure(static_cast<int>(path.spec.rate), 16000);
+    resample_buf_.assign(resampler_.max_output(max_frames), 0.0f);
+#ifdef SPEAK_S16_SAMPLES
+    sample_buf_.assign(resample_buf_.size(), 0);
+#endif
+    vad_.sink = [this](const float* samples, size_t count) { push(samples, count); };
+    vad_.on_event = [this](const VadEvent& e) { vad_events_.push(e); };
+    vad_.configure(16000);
+    pre_roll_.resize(static_cast<size_t>(path.spec.rate) * static_cast<size_t>(std::max(0, pre_roll_ms)) / 1000);
+    seen_generation_ = generation_.load();
+    hardware_sr_ = path.spec.rate;
+    path_ = path;
+
+    backend_ = std::move(b);
+    {
+        std::lock_guard<std::mutex> slk(sched_mu_);
+        scheduling_.clear();
+    }
+    tune_thread_.store(true, std::memory_order_relaxed);
+    running_.store(true, std::memory_order_release);
+    fprintf(stderr, "[AudioEngine] Engine started (%s, %s, %d ms frames, device: %s)\n",
+            backend_->name(), path_.describe().c_str(), frame_ms,
+            source.empty() ? "default" : source.c_str());
 }
 
 void AudioEngine::start_recording() {
-    if (!pa_) prepare();
-    vad_.reset();
-    buffer_.drain();
-    collecting_ = true;
+    if (!running_) prepare();
+    stop_drain();
+    {
+        std::lock_guard<std::mutex> lk(store_mu_);
+        buffer_.clear();
+        vad_events_.clear();
+        store_ = std::make_unique<RecordingStore>(
+            static_cast<size_t>(std::max(0, recording_ram_limit_mb)) << 20);
+        mel_.configure(mel_bins, MEL_MAX_SAMPLES, &mel_filters);
+#ifdef SPEAK_S16_SAMPLES
+        if (mel_.enabled()) mel_scratch_.resize(4096);
+#endif
+        drain_running_ = true;
+    }
+    generation_.fetch_add(1, std::memory_order_relaxed);
+    collecting_.store(true, std::memory_order_release);
+    drain_thread_ = std::thread(&AudioEngine::drain_loop, this);
     fprintf(stderr, "[AudioEngine] Recording started\n");
 }
 
-std::vector<float> AudioEngine::stop_recording() {
+std::unique_ptr<RecordingStore> AudioEngine::stop_recording() {
     collecting_ = false;
+    stop_drain();
 
-    auto raw = buffer_.drain();
-    vad_.reset();
+    std::unique_ptr<RecordingStore> recording;
+    {
+        std::lock_guard<std::mutex> lk(store_mu_);
+        flush_ring();
+        recording = std::move(store_);
+    }
+    if (!recording) recording = std::make_unique<RecordingStore>();
 
-    fprintf(stderr, "\n[AudioEngine] Stopped. Raw samples: %zu (%.1fs), mic level: %.4f\n",
-            raw.size(), static_cast<double>(raw.size()) / hardware_sr_,
+    fprintf(stderr, "\n[AudioEngine] Stopped. Samples: %zu (%.1fs at 16kHz), mic level: %.4f\n",
+            recording->size(), static_cast<double>(recording->size()) / 16000.0,
             audio_level_.load(std::memory_order_relaxed));
 
-    if (raw.empty()) return {};
+    if (recording->spilled_bytes() > 0) {
+        fprintf(stderr, "[AudioEngine] Recording: %.1f MB in RAM, %.1f MB spilled to disk\n",
+                static_cast<double>(recording->resident_bytes()) / (1 << 20),
+                static_cast<double>(recording->spilled_bytes()) / (1 << 20));
+    }
+
+    if (buffer_.dropped() > 0) {
+        fprintf(stderr, "[AudioEngine] Ring overflow: %llu samples dropped so far\n",
+                static_cast<unsigned long long>(buffer_.dropped()));
+    }
+
+    return recording;
+}
 
-    auto resampled = resample(raw, hardware_sr_, 16000);
-    fprintf(stderr, "[AudioEngine] Resampled to %zu samples (%.1fs at 16kHz)\n",
-            resampled.size(), static_cast<double>(resampled.size()) / 16000.0);
-    return resampled;
+size_t AudioEngine::recorded_samples() const {
+    std::lock_guard<std::mutex> lk(store_mu_);
+    return buffer_.count() + (store_ ? store_->size() : 0);
+}
+
+bool AudioEngine::take_mel(MelSpectrogram& out) {
+    std::lock_guard<std::mutex> lk(store_mu_);
+    bool ok = mel_.finish(out);
+    mel_.reset();
+    return ok;
+}
+
+std::vector<float> AudioEngine::take_recorded() {
+    std::lock_guard<std::mutex> lk(store_mu_);
+    if (!store_) return {};
+    flush_ring();
+    auto samples = store_->read(0, store_->size());
+    store_->clear();
+    return samples;
+}
+
+// Moves whatever the capture thread has produced out of the ring and into
+// the recording store. Caller holds store_mu_.
+void AudioEngine::flush_ring() {
+    auto span = buffer_.read_span();
+    if (span.empty()) return;
+    if (store_) {
+        store_->append(span.first, span.first_len);
+        store_->append(span.second, span.second_len);
+        feed_mel(span.first, span.first_len);
+        feed_mel(span.second, span.second_len);
+    }
+    buffer_.consume(span.size());
+}
+
+void AudioEngine::feed_mel(const sample_t* samples, size_t count) {
+    if (!mel_.enabled() || mel_.overflowed()) return;
+#ifdef SPEAK_S16_SAMPLES
+    for (size_t off = 0; off < count; off += mel_scratch_.size()) {
+        size_t n = std::min(mel_scratch_.size(), count - off);
+        from_samples(samples + off, mel_scratch_.data(), n);
+        mel_.append(mel_scratch_.data(), n);
+    }
+#else
+    mel_.append(samples, count);
+#endif
+}
+
+void AudioEngine::drain_loop() {
+    std::unique_lock<std::mutex> lk(store_mu_);
+    while (drain_running_) {
+        drain_cv_.wait_for(lk, std::chrono::milliseconds(DRAIN_INTERVAL_MS));
+        flush_ring();
+    }
+}
+
+void AudioEngine::stop_drain() {
+    {
+        std::lock_guard<std::mutex> lk(store_mu_);
+        drain_running_ = false;
+    }
+    drain_cv_.notify_all();
+    if (drain_thread_.joinable()) drain_thread_.join();
 }
 
 void AudioEngine::release() {
     running_ = false;
     collecting_ = false;
-    if (capture_thread_.joinable()) capture_thread_.join();
-    if (pa_) {
-        pa_simple_free(pa_);
-        pa_ = nullptr;
+    stop_drain();
+    std::unique_ptr<CaptureBackend> b;
+    {
+        std::lock_guard<std::mutex> lk(backend_mu_);
+        b = std::move(backend_);
     }
+    if (b) b->close();
 }
 
-void AudioEngine::capture_loop() {
-    constexpr size_t FRAME = 4096;
-    std::vector<float> buf(FRAME);
-    int err = 0;
-    while (running_) {
-        if (pa_simple_read(pa_, buf.data(), FRAME * sizeof(float), &err) < 0) {
-            fprintf(stderr, "[AudioEngine] read error: %s\n", pa_strerror(err));
-            break;
+void AudioEngine::on_frames(const void* data, size_t frames) {
+    if (!running_.load(std::memory_order_acquire)) return;
+    if (tune_thread_.load(std::memory_order_relaxed) && tune_thread_.exchange(false)) {
+        tune_capture_thread();
+    }
+
+    const size_t chunk = convert_buf_.size();
+    if (path_.spec.format == SampleFormat::f32) {
+        const float* in = static_cast<const float*>(data);
+        for (size_t off = 0; off < frames; off += chunk) {
+            process_frames(in + off, std::min(chunk, frames - off));
         }
+        return;
+    }
+
+    const int16_t* in = static_cast<const int16_t*>(data);
+    for (size_t off = 0; off < frames; off += chunk) {
+        size_t n = std::min(chunk, frames - off);
+        Simd::s16_to_float(in + off, convert_buf_.data(), n);
+        process_frames(convert_buf_.data(), n);
+    }
+}
 
-        float sum_sq = 0;
-        for (size_t i = 0; i < FRAME; ++i) sum_sq += buf[i] * buf[i];
-        float rms = std::sqrt(sum_sq / static_cast<float>(FRAME));
-        audio_level_.store(std::min(1.0f, rms), std::memory_order_relaxed);
+void AudioEngine::process_frames(const float* samples, size_t frames) {
+    if (frames == 0) return;
 
-        if (!collecting_) continue;
+    float sum_sq = 0;
+    for (size_t i = 0; i < frames; ++i) sum_sq += samples[i] * samples[i];
+    float rms = std::sqrt(sum_sq / static_cast<float>(frames));
+    audio_level_.store(std::min(1.0f, rms), std::memory_order_relaxed);
 
-        auto filtered = vad_.process(buf.data(), FRAME, static_cast<int>(hardware_sr_));
-        if (!filtered.empty()) {
-            buffer_.append(filtered.data(), filtered.size());
-        }
+    if (!collecting_.load(std::memory_order_acquire)) {
+        pre_roll_.push(samples, frames);
+        return;
+    }
+
+    // First frame of a recording: start resampler and VAD from a clean state
+    // and feed them the pre-roll, so speech that began just before the
+    // hotkey registered is kept. The history is read in place.
+    uint64_t gen = generation_.load(std::memory_order_relaxed);
+    if (gen != seen_generation_) {
+        seen_generation_ = gen;
+        vad_.reset();
+        resampler_.reset();
+        auto pre = pre_roll_.spans();
+        record(pre.first, pre.first_len);
+        record(pre.second, pre.second_len);
+        pre_roll_.clear();
     }
-}
 
-std::vector<float> AudioEngine::resample_public(const std::vector<float>& input) {
-    return resample(input, hardware_sr_, 16000);
+    record(samples, frames);
 }
 
-std::vector<float> AudioEngine::resample(const std::vector<float>& input, double from, double to) {
-    if (from == to || input.empty()) return input;
+// Decimate to 16 kHz first so the VAD, its padding buffers and everything
+// downstream only ever see the rate whisper uses.
+void AudioEngine::record(const float* samples, size_t frames) {
+    if (frames == 0) return;
+    if (resampler_.passthrough()) {
+        vad_.process(samples, frames, 16000);
+        return;
+    }
 
-    double ratio = from / to;
-    size_t out_count = static_cast<size_t>(static_cast<double>(input.size()) / ratio);
-    if (out_count == 0) return {};
+    // The pre-roll arrives in one go, so walk the input in chunks that fit
+    // the preallocated resampler output.
+    const size_t chunk = convert_buf_.size();
+    for (size_t off = 0; off < frames; off += chunk) {
+        size_t n = std::min(chunk, frames - off);
+        size_t produced = resampler_.process(samples + off, n, resample_buf_.data());
+        vad_.process(resample_buf_.data(), produced, 16000);
+    }
+}
 
-    std::vector<float> output(out_count);
-    for (size_t i = 0; i < out_count; ++i) {
-        double src_idx = static_cast<double>(i) * ratio;
-        size_t idx0 = static_cast<size_t>(src_idx);
-        float frac = static_cast<float>(src_idx - static_cast<double>(idx0));
-        size_t idx1 = std::min(idx0 + 1, input.size() - 1);
-        output[i] = input[idx0] * (1.0f - frac) + input[idx1] * frac;
+void AudioEngine::push(const float* samples, size_t count) {
+#ifdef SPEAK_S16_SAMPLES
+    const size_t chunk = sample_buf_.size();
+    for (size_t off = 0; off < count; off += chunk) {
+        size_t n = std::min(chunk, count - off);
+        to_samples(samples + off, sample_buf_.data(), n);
+        buffer_.append(sample_buf_.data(), n);
     }
-    return output;
+#else
+    buffer_.append(samples, count);
+#endif
 }
@@ -1,43 +1,132 @@
 #pragma once
 
 #include "ring_buffer.h"
+#include "recording_store.h"
+#include "log_mel.h"
 #include "vad.h"
+#include "resampler.h"
+#include "circular_buffer.h"
+#include "capture_backend.h"
+#include "settings.h"
 #include <atomic>
-#include <thread>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <functional>
-#include <pulse/simple.h>
+
+// How captured audio gets from the backend's format to 16 kHz float.
+enum class CaptureConversion { none, format, decimate, resample };
+
+struct CapturePath {
+    CaptureSpec spec;  // what the stream was opened with
+    CaptureConversion conversion = CaptureConversion::resample;
+    int up = 1;
+    int down = 1;
+
+    std::string describe() const;
+};
 
 class AudioEngine {
 public:
     ~AudioEngine();
 
     std::string device;
+    CaptureFormat capture_format = CaptureFormat::native;
+    AudioBackend backend = AudioBackend::pulse_stream;
+    int frame_ms = 20;
+    int pre_roll_ms = 400;
+    int recording_ram_limit_mb = 64;
+    bool realtime = true;
+    int rt_priority = 10;
+    int capture_cpu = -1;  // -1: no pinning
+    // Mel bins to compute on the drain thread as the recording grows (the
+    // model's n_mels), or 0 for none, and the model's filterbank (see
+    // LogMel). Read by start_recording().
+    int mel_bins = 0;
+    std::vector<float> mel_filters;
 
     void prepare();
+    // Runs `backend` on `source` instead of the backend the fields above
+    // pick; everything past choosing it is the same as prepare().
+    void prepare(std::unique_ptr<CaptureBackend> backend, const std::string& source);
     void start_recording();
-    std::vector<float> stop_recording();
+    std::unique_ptr<RecordingStore> stop_recording();
     void release();
+    bool is_prepared() const { return running_; }
 
     VoiceActivityDetector& vad() { return vad_; }
-    RingBuffer& raw_buffer() { return buffer_; }
+    // Speech start/end of the current recording, in 16 kHz samples.
+    VadEventQueue& vad_events() { return vad_events_; }
+    // Continuous mode: samples recorded so far, and taking them out of the
+    // current recording.
+    size_t recorded_samples() const;
+    std::vector<float> take_recorded();
+    // Buffered mode: the spectrogram of the recording just stopped, if it
+    // was computed and fit in MEL_MAX_SAMPLES.
+    bool take_mel(MelSpectrogram& out);
+    uint64_t dropped_samples() const { return buffer_.dropped(); }
     double hardware_sample_rate() const { return hardware_sr_; }
+    const CapturePath& capture_path() const { return path_; }
+    const char* backend_name() const;
+    CaptureStats capture_stats() const;
+    std::string capture_scheduling() const;
     std::atomic<float>& audio_level() { return audio_level_; }
 
-    std::vector<float> resample_public(const std::vector<float>& input);
-
     static void list_devices();
+    static std::unique_ptr<CaptureBackend> create_backend(AudioBackend kind);
 
 private:
-    pa_simple* pa_ = nullptr;
+    // ~65 s at 16 kHz. The drain thread empties it into the recording store
+    // every DRAIN_INTERVAL_MS, so it only has to absorb scheduling hiccups.
+    static constexpr size_t RING_CAPACITY = size_t(1) << 20;
+    static constexpr int DRAIN_INTERVAL_MS = 250;
+    static constexpr size_t MEL_MAX_SAMPLES = 16000 * 30;
+
+    std::unique_ptr<CaptureBackend> backend_;
+    mutable std::mutex backend_mu_;
     VoiceActivityDetector vad_;
-    RingBuffer buffer_;
+    VadEventQueue vad_events_;
+    RingBuffer buffer_{RING_CAPACITY};
+    Resampler resampler_;
+    CapturePath path_;
     double hardware_sr_ = 48000;
     std::atomic<bool> running_{false};
     std::atomic<bool> collecting_{false};
+    std::atomic<uint64_t> generation_{0};
     std::atomic<float> audio_level_{0};
-    std::thread capture_thread_;
 
-    void capture_loop();
-    static std::vector<float> resample(const std::vector<float>& input, double from, double to);
+    // Set by prepare(); the first callback then tunes whichever thread the
+    // backend delivers on.
+    std::atomic<bool> tune_thread_{false};
+    mutable std::mutex sched_mu_;
+    std::string scheduling_;
+
+    // Ring consumer side: the drain thread and the pipeline's readers.
+    mutable std::mutex store_mu_;
+    std::unique_ptr<RecordingStore> store_;
+    std::thread drain_thread_;
+    std::condition_variable drain_cv_;
+    bool drain_running_ = false;
+    LogMel mel_;
+    std::vector<float> mel_scratch_;
+
+    // Audio-thread state.
+    uint64_t seen_generation_ = 0;
+    CircularBuffer<float> pre_roll_;
+    std::vector<float> convert_buf_;
+    std::vector<float> resample_buf_;
+    std::vector<sample_t> sample_buf_;
+
+    void on_frames(const void* data, size_t frames);
+    void tune_capture_thread();
+    void process_frames(const float* samples, size_t frames);
+    void record(const float* samples, size_t frames);
+    void push(const float* samples, size_t count);
+    CapturePath negotiate_path(const std::string& source) const;
+    void drain_loop();
+    void stop_drain();
+    void flush_ring();
+    void feed_mel(const sample_t* samples, size_t count);
 };
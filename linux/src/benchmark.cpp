@@ -1,5 +1,12 @@
 #include "benchmark.h"
 #include "performance_monitor.h"
+#include "audio_engine.h"
+#include "pulse_capture.h"
+#include "model_manager.h"
+#include "vad.h"
+#include "resampler.h"
+#include "wav_reader.h"
+#include "whisper_context.h"
 #include "whisper.h"
 #include <vector>
 #include <cstdio>
@@ -7,6 +14,10 @@
 #include <chrono>
 #include <algorithm>
 #include <thread>
+#include <atomic>
+#include <random>
+#include <cctype>
+#include <filesystem>
 
 static std::vector<float> generate_tone(double duration_s, int sr = 16000, float base_freq = 440.0f) {
     int count = static_cast<int>(duration_s * sr);
@@ -37,7 +48,39 @@ static std::vector<float> generate_with_gap(double total, double gap_start, doub
     return samples;
 }
 
-void run_benchmark(const std::string& model_path) {
+// Word error rate of `hyp` against `ref`, ignoring case and punctuation.
+static double word_error_rate(const std::string& ref, const std::string& hyp) {
+    auto words = [](const std::string& text) {
+        std::vector<std::string> out;
+        std::string w;
+        for (char ch : text + " ") {
+            unsigned char c = static_cast<unsigned char>(ch);
+            if (std::isspace(c)) {
+                if (!w.empty()) out.push_back(w);
+                w.clear();
+            } else if (std::isalnum(c) || c >= 0x80) {
+                w += static_cast<char>(std::tolower(c));
+            }
+        }
+        return out;
+    };
+    auto r = words(ref);
+    auto h = words(hyp);
+    if (r.empty()) return h.empty() ? 0.0 : 1.0;
+
+    std::vector<size_t> prev(h.size() + 1), cur(h.size() + 1);
+    for (size_t j = 0; j <= h.size(); ++j) prev[j] = j;
+    for (size_t i = 1; i <= r.size(); ++i) {
+        cur[0] = i;
+        for (size_t j = 1; j <= h.size(); ++j) {
+            cur[j] = std::min({prev[j] + 1, cur[j - 1] + 1, prev[j - 1] + (r[i - 1] == h[j - 1] ? 0 : 1)});
+        }
+        std::swap(prev, cur);
+    }
+    return static_cast<double>(prev[h.size()]) / static_cast<double>(r.size());
+}
+
+void run_benchmark(const std::string& model_path, const std::vector<std::string>& wav_paths) {
     printf("SpeakBenchmark\n==============\nModel: %s\n\n", model_path.c_str());
 
     printf("Loading model...\n");
@@ -53,23 +96,40 @@ void run_benchmark(const std::string& model_path) {
         std::chrono::steady_clock::now() - load_start).count();
     printf("Model loaded in %.0f ms\n\n", load_ms);
 
-    struct Scenario { const char* name; std::vector<float> samples; };
-    Scenario scenarios[] = {
+    struct Scenario { std::string name; std::vector<float> samples; };
+    std::vector<Scenario> scenarios = {
         {"Short utterance (2s)",       generate_tone(2.0)},
         {"Medium utterance (10s)",     generate_tone(10.0)},
         {"Long recording (60s)",       generate_tone(60.0)},
         {"Silence gap (5s, 2s gap)",   generate_with_gap(5.0, 1.5, 2.0)},
     };
+    // Real speech, so the audio_ctx rows below mean something.
+    for (auto& path : wav_paths) {
+        std::vector<float> audio;
+        int rate = 0;
+        if (!read_wav(path, audio, rate)) {
+            printf("Skipping %s: not a readable WAV\n", path.c_str());
+            continue;
+        }
+        if (rate != 16000) audio = Resampler(rate, 16000).resample(audio);
+        std::string name = std::filesystem::path(path).filename().string();
+        if (name.size() > 28) name = name.substr(0, 25) + "...";
+        scenarios.push_back({name, std::move(audio)});
+    }
+
+    // Dynamic audio_ctx is compared against the full window with the
+    // default margin and floor; WER is measured against the full window.
+    Settings dynamic;
+    dynamic.dynamic_audio_ctx = true;
+    std::string model_name = std::filesystem::path(model_path).stem().string();
+    bool tuned = WhisperContext::tuned_for_audio_ctx(model_name);
 
     printf("%-28s  %8s  %10s  %7s  %4s  %8s\n", "Scenario", "Audio", "Transc.", "RTF", "Seg", "Mem MB");
     printf("------------------------------------------------------------------------\n");
 
     int threads = std::max(1, std::min(8, static_cast<int>(std::thread::hardware_concurrency()) - 2));
 
-    for (auto& sc : scenarios) {
-        double audio_ms = static_cast<double>(sc.samples.size()) / 16000.0 * 1000.0;
-        double mem_before = PerformanceMonitor::resident_memory_mb();
-
+    auto run = [&](const std::vector<float>& samples, int audio_ctx, int& n_seg, std::string& text) {
         auto params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
         params.n_threads = threads;
         params.no_context = true;
@@ -78,17 +138,15 @@ void run_benchmark(const std::string& model_path) {
         params.print_realtime = false;
         params.print_timestamps = false;
         params.language = "en";
+        params.audio_ctx = audio_ctx;
 
         auto start = std::chrono::steady_clock::now();
-        int res = whisper_full(ctx, params, sc.samples.data(), static_cast<int>(sc.samples.size()));
+        int res = whisper_full(ctx, params, samples.data(), static_cast<int>(samples.size()));
         double elapsed = std::chrono::duration<double, std::milli>(
             std::chrono::steady_clock::now() - start).count();
 
-        double mem_after = PerformanceMonitor::resident_memory_mb();
-        double rtf = audio_ms > 0 ? elapsed / audio_ms : 0;
-
-        int n_seg = 0;
-        std::string text;
+        n_seg = 0;
+        text.clear();
         if (res == 0) {
             n_seg = whisper_full_n_segments(ctx);
             for (int i = 0; i < n_seg; ++i) {
@@ -96,23 +154,168 @@ void run_benchmark(const std::string& model_path) {
                 if (s) text += s;
             }
         }
+        return elapsed;
+    };
+
+    auto format_ms = [](char* buf, size_t size, double ms) {
+        if (ms < 1000) std::snprintf(buf, size, "%.0f ms", ms);
+        else std::snprintf(buf, size, "%.2f s", ms / 1000.0);
+    };
+
+    for (auto& sc : scenarios) {
+        double audio_ms = static_cast<double>(sc.samples.size()) / 16000.0 * 1000.0;
+        double mem_before = PerformanceMonitor::resident_memory_mb();
+
+        int n_seg = 0;
+        std::string text;
+        double elapsed = run(sc.samples, 0, n_seg, text);
+
+        double mem_after = PerformanceMonitor::resident_memory_mb();
+        double rtf = audio_ms > 0 ? elapsed / audio_ms : 0;
 
         char audio_str[32], transc_str[32];
         if (audio_ms < 1000) std::snprintf(audio_str, sizeof(audio_str), "%.0f ms", audio_ms);
         else std::snprintf(audio_str, sizeof(audio_str), "%.1f s", audio_ms / 1000.0);
-
-        if (elapsed < 1000) std::snprintf(transc_str, sizeof(transc_str), "%.0f ms", elapsed);
-        else std::snprintf(transc_str, sizeof(transc_str), "%.2f s", elapsed / 1000.0);
+        format_ms(transc_str, sizeof(transc_str), elapsed);
 
         printf("%-28s  %8s  %10s  %6.3fx  %4d  %7.1f\n",
-               sc.name, audio_str, transc_str, rtf, n_seg, mem_after - mem_before);
+               sc.name.c_str(), audio_str, transc_str, rtf, n_seg, mem_after - mem_before);
 
-        if (!text.empty()) {
-            if (text.size() > 80) text = text.substr(0, 80) + "...";
-            printf("  -> %s\n", text.c_str());
+        std::string shown = text;
+        if (!shown.empty()) {
+            if (shown.size() > 80) shown = shown.substr(0, 80) + "...";
+            printf("  -> %s\n", shown.c_str());
+        }
+
+        int audio_ctx = WhisperContext::audio_ctx_for(sc.samples.size(), dynamic, tuned);
+        if (audio_ctx > 0) {
+            int dyn_seg = 0;
+            std::string dyn_text;
+            double dyn_elapsed = run(sc.samples, audio_ctx, dyn_seg, dyn_text);
+            format_ms(transc_str, sizeof(transc_str), dyn_elapsed);
+            printf("  audio_ctx %-4d %21s  %6.3fx  %4d  %4.1fx faster, WER vs full %.1f%%\n",
+                   audio_ctx, transc_str, audio_ms > 0 ? dyn_elapsed / audio_ms : 0, dyn_seg,
+                   dyn_elapsed > 0 ? elapsed / dyn_elapsed : 0, 100.0 * word_error_rate(text, dyn_text));
         }
     }
 
     whisper_free(ctx);
     printf("\nDone.\n");
 }
+
+void run_capture_benchmark(const std::string& device, int seconds, int frame_ms) {
+    printf("Capture latency\n===============\nDevice: %s, %d ms frames, %d s per backend\n\n",
+           device.empty() ? "default" : device.c_str(), frame_ms, seconds);
+
+    printf("%-14s  %-22s  %6s  %9s  %9s  %9s  %9s  %8s\n",
+           "Backend", "Format", "Calls", "Frame ms", "Mean gap", "Max gap", "Latency", "Overruns");
+    printf("--------------------------------------------------------------------------------------------------\n");
+
+    AudioBackend kinds[] = { AudioBackend::pulse_simple, AudioBackend::pulse_stream, AudioBackend::pipewire };
+    for (auto kind : kinds) {
+        auto backend = AudioEngine::create_backend(kind);
+        if (!backend) {
+            printf("%-14s  not built in\n", audio_backend_name(kind));
+            continue;
+        }
+
+        CaptureSpec spec;
+        PulseCapture::query_source_spec(device, spec);
+
+        // Callback timestamps go into a preallocated array so the audio
+        // thread does nothing but store a clock reading.
+        std::vector<int64_t> stamps(static_cast<size_t>(seconds) * 2000);
+        std::atomic<size_t> n_stamps{0};
+        std::atomic<uint64_t> total_frames{0};
+        auto t0 = std::chrono::steady_clock::now();
+
+        bool ok = backend->open(device, spec, frame_ms, [&](const void*, size_t frames) {
+            size_t i = n_stamps.fetch_add(1, std::memory_order_relaxed);
+            if (i < stamps.size()) {
+                stamps[i] = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - t0).count();
+            }
+            total_frames.fetch_add(frames, std::memory_order_relaxed);
+        });
+        if (!ok) {
+            printf("%-14s  failed to open\n", backend->name());
+            continue;
+        }
+
+        std::this_thread::sleep_for(std::chrono::seconds(seconds));
+        CaptureStats st = backend->stats();
+        backend->close();
+
+        size_t n = std::min(n_stamps.load(), stamps.size());
+        double mean_gap = 0, max_gap = 0;
+        if (n > 2) {
+            // Skip the first callback: it carries whatever queued during connect.
+            for (size_t i = 2; i < n; ++i) {
+                double gap = static_cast<double>(stamps[i] - stamps[i - 1]) / 1000.0;
+                mean_gap += gap;
+                max_gap = std::max(max_gap, gap);
+            }
+            mean_gap /= static_cast<double>(n - 2);
+        }
+        double frame_len = n > 0
+            ? static_cast<double>(total_frames.load()) / static_cast<double>(n) * 1000.0 / spec.rate : 0;
+
+        char fmt[32];
+        std::snprintf(fmt, sizeof(fmt), "%s %u Hz", sample_format_name(spec.format), spec.rate);
+        char overruns[24] = "-";
+        if (st.overruns_reported) std::snprintf(overruns, sizeof(overruns), "%llu", static_cast<unsigned long long>(st.overruns));
+        printf("%-14s  %-22s  %6zu  %9.1f  %9.1f  %9.1f  %9.1f  %8s\n",
+               backend->name(), fmt, n, frame_len, mean_gap, max_gap, st.latency_ms, overruns);
+    }
+    printf("\nDone.\n");
+}
+
+// Per-frame cost of each VAD backend on the same synthetic input: tone
+// bursts with gaps over light noise, fed in 20 ms callbacks like capture.
+void run_vad_benchmark(int seconds) {
+    printf("VAD benchmark (%d s of audio per run, 30 ms frames)\n\n", seconds);
+    printf("%-10s  %7s  %10s  %9s\n", "Backend", "Rate", "ns/frame", "Kept s");
+    printf("----------------------------------------------\n");
+
+    std::string silero_path = ModelManager::vad_model_path();
+    VadBackend backends[] = { VadBackend::energy, VadBackend::spectral, VadBackend::silero };
+
+    for (int sr : {16000, 48000}) {
+        std::vector<float> audio;
+        for (int s = 0; s < seconds; s += 5) {
+            auto part = generate_with_gap(5.0, 2.5, 1.5, sr);
+            audio.insert(audio.end(), part.begin(), part.end());
+        }
+        std::mt19937 rng(7);
+        std::normal_distribution<float> noise(0.0f, 0.002f);
+        for (auto& v : audio) v += noise(rng);
+
+        const size_t chunk = static_cast<size_t>(sr) * 20 / 1000;
+        const size_t frames = audio.size() / (static_cast<size_t>(sr) * 30 / 1000);
+
+        for (auto kind : backends) {
+            VoiceActivityDetector vad;
+            vad.backend = kind;
+            if (kind == VadBackend::silero && (silero_path.empty() || !vad.load_silero(silero_path, false))) {
+                printf("%-10s  %7d  %10s\n", vad_backend_name(kind), sr, "no model");
+                continue;
+            }
+
+            size_t kept = 0;
+            vad.sink = [&](const float*, size_t n) { kept += n; };
+            vad.configure(sr);
+            vad.reset();
+
+            auto start = std::chrono::steady_clock::now();
+            for (size_t off = 0; off < audio.size(); off += chunk) {
+                vad.process(audio.data() + off, std::min(chunk, audio.size() - off), sr);
+            }
+            double ns = std::chrono::duration<double, std::nano>(
+                std::chrono::steady_clock::now() - start).count();
+
+            printf("%-10s  %7d  %10.0f  %9.1f\n", vad_backend_name(kind), sr,
+                   ns / static_cast<double>(frames), static_cast<double>(kept) / sr);
+        }
+    }
+    printf("\nDone.\n");
+}
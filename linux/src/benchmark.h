@@ -1,5 +1,8 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
-void run_benchmark(const std::string& model_path);
+void run_benchmark(const std::string& model_path, const std::vector<std::string>& wav_paths = {});
+void run_capture_benchmark(const std::string& device, int seconds, int frame_ms);
+void run_vad_benchmark(int seconds);
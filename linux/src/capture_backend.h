@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+enum class SampleFormat { f32, s16 };
+
+struct CaptureSpec {
+    SampleFormat format = SampleFormat::f32;
+    uint32_t rate = 48000;
+};
+
+struct CaptureStats {
+    uint64_t callbacks = 0;
+    // Only meaningful when overruns_reported: the simple API and PipeWire's
+    // stream API do not tell a client about capture xruns.
+    bool overruns_reported = false;
+    uint64_t overruns = 0;
+    // Callbacks that found no buffer to dequeue (PipeWire). Nothing was
+    // lost, so these are not overruns.
+    uint64_t empty_dequeues = 0;
+    double latency_ms = 0;  // most recent source latency the server reported
+};
+
+// A source of mono capture frames. open() blocks until the stream runs,
+// then `on_frames` is called from the backend's own audio thread with
+// `frames` samples in the format the backend returned in spec.
+class CaptureBackend {
+public:
+    using Callback = std::function<void(const void* data, size_t frames)>;
+
+    virtual ~CaptureBackend() = default;
+
+    // `spec` is a request; backends may adjust it to what they actually opened.
+    virtual bool open(const std::string& device, CaptureSpec& spec, int frame_ms, Callback on_frames) = 0;
+    virtual void close() = 0;
+    virtual const char* name() const = 0;
+    virtual CaptureStats stats() const = 0;
+};
+
+inline size_t sample_size(SampleFormat f) {
+    return f == SampleFormat::s16 ? sizeof(int16_t) : sizeof(float);
+}
+
+inline const char* sample_format_name(SampleFormat f) {
+    return f == SampleFormat::s16 ? "s16le" : "float32le";
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+// Fixed-capacity history buffer for a single thread: push() overwrites the
+// oldest samples once full, and spans() exposes the contents oldest-first
+// without copying. Only resize() allocates.
+template <typename T>
+class CircularBuffer {
+public:
+    struct Spans {
+        const T* first = nullptr;
+        size_t first_len = 0;
+        const T* second = nullptr;
+        size_t second_len = 0;
+
+        size_t size() const { return first_len + second_len; }
+    };
+
+    void resize(size_t capacity) {
+        data_.assign(capacity, T{});
+        head_ = 0;
+        size_ = 0;
+    }
+
+    size_t capacity() const { return data_.size(); }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    void clear() { head_ = 0; size_ = 0; }
+
+    void push(const T* data, size_t count) {
+        const size_t cap = data_.size();
+        if (cap == 0) return;
+        if (count >= cap) {
+            data += count - cap;
+            count = cap;
+        }
+        size_t pos = (head_ + size_) % cap;
+        size_t first = count < cap - pos ? count : cap - pos;
+        std::copy(data, data + first, data_.begin() + static_cast<std::ptrdiff_t>(pos));
+        std::copy(data + first, data + count, data_.begin());
+
+        size_ += count;
+        if (size_ > cap) {
+            head_ = (head_ + size_ - cap) % cap;
+            size_ = cap;
+        }
+    }
+
+    // Drops the oldest `count` samples.
+    void discard(size_t count) {
+        if (count >= size_) { clear(); return; }
+        head_ = (head_ + count) % data_.size();
+        size_ -= count;
+    }
+
+    Spans spans() const {
+        Spans s;
+        if (size_ == 0) return s;
+        const size_t cap = data_.size();
+        s.first = data_.data() + head_;
+        s.first_len = size_ < cap - head_ ? size_ : cap - head_;
+        s.second = data_.data();
+        s.second_len = size_ - s.first_len;
+        return s;
+    }
+
+private:
+    std::vector<T> data_;
+    size_t head_ = 0;
+    size_t size_ = 0;
+};
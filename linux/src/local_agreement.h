@@ -0,0 +1,75 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Commit policy for streaming decoding (LocalAgreement-2): the window is
+// re-decoded as audio arrives, and a word is committed once two consecutive
+// hypotheses agree on it and on everything before it. Words are compared
+// ignoring case and punctuation, which whisper often revises; the later
+// hypothesis's spelling is the one emitted.
+class LocalAgreement {
+public:
+    static std::vector<std::string> split_words(const std::string& text) {
+        std::vector<std::string> words;
+        std::istringstream ss(text);
+        std::string w;
+        while (ss >> w) words.push_back(w);
+        return words;
+    }
+
+    // Takes a hypothesis for the whole window and returns the words newly
+    // committed by it.
+    std::vector<std::string> update(const std::vector<std::string>& hypothesis) {
+        std::vector<std::string> out;
+        size_t i = committed_;
+        while (i < hypothesis.size() && i < previous_.size() && same(hypothesis[i], previous_[i])) {
+            out.push_back(hypothesis[i]);
+            ++i;
+        }
+        committed_ = std::max(committed_, i);
+        previous_ = hypothesis;
+        return out;
+    }
+
+    // Commits whatever the latest hypothesis has beyond the committed prefix,
+    // for when the utterance is over and no later hypothesis will come.
+    std::vector<std::string> flush() {
+        std::vector<std::string> out;
+        for (size_t i = committed_; i < previous_.size(); ++i) out.push_back(previous_[i]);
+        committed_ = previous_.size();
+        return out;
+    }
+
+    // The first `words` words of the window, all committed, were dropped
+    // together with their audio.
+    void trim(size_t words) {
+        words = std::min(words, committed_);
+        previous_.erase(previous_.begin(), previous_.begin() + static_cast<std::ptrdiff_t>(std::min(words, previous_.size())));
+        committed_ -= words;
+    }
+
+    void reset() {
+        previous_.clear();
+        committed_ = 0;
+    }
+
+    size_t committed() const { return committed_; }
+
+private:
+    std::vector<std::string> previous_;
+    size_t committed_ = 0;
+
+    static std::string normalize(const std::string& w) {
+        std::string n;
+        for (unsigned char c : w) {
+            if (std::isalnum(c) || c >= 0x80) n += static_cast<char>(std::tolower(c));
+        }
+        return n;
+    }
+    static bool same(const std::string& a, const std::string& b) { return normalize(a) == normalize(b); }
+};
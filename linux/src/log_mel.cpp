@@ -0,0 +1,183 @@
+#include "log_mel.h"
+#include "simd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+
+static constexpr double PI = 3.14159265358979323846;
+static constexpr int SAMPLE_RATE = 16000;
+
+// librosa's Slaney mel scale: linear below 1 kHz, logarithmic above.
+static double hz_to_mel(double hz) {
+    const double f_sp = 200.0 / 3.0;
+    const double min_log_hz = 1000.0;
+    const double logstep = std::log(6.4) / 27.0;
+    if (hz < min_log_hz) return hz / f_sp;
+    return min_log_hz / f_sp + std::log(hz / min_log_hz) / logstep;
+}
+
+static double mel_to_hz(double mel) {
+    const double f_sp = 200.0 / 3.0;
+    const double min_log_hz = 1000.0;
+    const double min_log_mel = min_log_hz / f_sp;
+    const double logstep = std::log(6.4) / 27.0;
+    if (mel < min_log_mel) return mel * f_sp;
+    return min_log_hz * std::exp(logstep * (mel - min_log_mel));
+}
+
+// Triangles between n_mel + 2 points evenly spaced in mel over 0..8 kHz,
+// each scaled to unit area (Slaney normalisation).
+static void slaney_filters(int n_mel, std::vector<float>& out) {
+    const size_t bins = LogMel::BINS;
+    std::vector<double> edges(static_cast<size_t>(n_mel) + 2);
+    double top = hz_to_mel(SAMPLE_RATE / 2.0);
+    for (size_t i = 0; i < edges.size(); ++i) {
+        edges[i] = mel_to_hz(top * static_cast<double>(i) / static_cast<double>(edges.size() - 1));
+    }
+    out.assign(static_cast<size_t>(n_mel) * bins, 0.0f);
+    for (size_t m = 0; m < static_cast<size_t>(n_mel); ++m) {
+        double enorm = 2.0 / (edges[m + 2] - edges[m]);
+        for (size_t k = 0; k < bins; ++k) {
+            double f = static_cast<double>(k) * SAMPLE_RATE / LogMel::N_FFT;
+            double lower = (f - edges[m]) / (edges[m + 1] - edges[m]);
+            double upper = (edges[m + 2] - f) / (edges[m + 2] - edges[m + 1]);
+            double w = std::max(0.0, std::min(lower, upper));
+            out[m * bins + k] = static_cast<float>(w * enorm);
+        }
+    }
+}
+
+void LogMel::configure(int n_mel, size_t max_samples, const std::vector<float>* filters) {
+    max_samples_ = max_samples;
+    if (n_mel != n_mel_) {
+        n_mel_ = std::max(0, n_mel);
+        filters_.clear();
+        if (n_mel_ == 0) {
+            reset();
+            return;
+        }
+
+        hann_.resize(N_FFT);
+        for (size_t i = 0; i < N_FFT; ++i) {
+            hann_[i] = static_cast<float>(0.5 * (1.0 - std::cos(2.0 * PI * static_cast<double>(i) / N_FFT)));
+        }
+
+        cos_.resize(BINS * N_FFT);
+        sin_.resize(BINS * N_FFT);
+        for (size_t k = 0; k < BINS; ++k) {
+            for (size_t n = 0; n < N_FFT; ++n) {
+                double a = 2.0 * PI * static_cast<double>((k * n) % N_FFT) / N_FFT;
+                cos_[k * N_FFT + n] = static_cast<float>(std::cos(a));
+                sin_[k * N_FFT + n] = static_cast<float>(-std::sin(a));
+            }
+        }
+
+        buf_.resize(N_FFT);
+        power_.resize(BINS);
+    }
+
+    if (filters && filters->size() == static_cast<size_t>(n_mel_) * BINS) {
+        filters_ = *filters;
+        model_filters_ = true;
+    } else if (filters_.empty() || model_filters_) {
+        slaney_filters(n_mel_, filters_);
+        model_filters_ = false;
+    }
+
+    audio_.reserve(max_samples_);
+    frames_.reserve(((max_samples_ + N_FFT / 2) / HOP + 1) * static_cast<size_t>(n_mel_));
+    reset();
+}
+
+bool LogMel::read_model_filters(const std::string& path, std::vector<float>& out) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+
+    // "ggml" magic, then the model's 11 int32 hyperparameters, then the
+    // filterbank as n_mel, n_fft (the bin count) and n_mel * n_fft floats.
+    uint32_t magic = 0;
+    int32_t hparams[11];
+    int32_t n_mel = 0, n_bins = 0;
+    in.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    in.read(reinterpret_cast<char*>(hparams), sizeof(hparams));
+    in.read(reinterpret_cast<char*>(&n_mel), sizeof(n_mel));
+    in.read(reinterpret_cast<char*>(&n_bins), sizeof(n_bins));
+    if (!in || magic != 0x67676d6c || n_mel <= 0 || n_mel > 512 || n_bins != static_cast<int32_t>(BINS)) return false;
+
+    out.resize(static_cast<size_t>(n_mel) * BINS);
+    in.read(reinterpret_cast<char*>(out.data()), static_cast<std::streamsize>(out.size() * sizeof(float)));
+    if (!in) {
+        out.clear();
+        return false;
+    }
+    return true;
+}
+
+void LogMel::reset() {
+    audio_.clear();
+    frames_.clear();
+    computed_ = 0;
+    overflowed_ = false;
+}
+
+void LogMel::append(const float* samples, size_t count) {
+    if (!enabled() || overflowed_) return;
+    if (audio_.size() + count > max_samples_) {
+        overflowed_ = true;
+        return;
+    }
+    audio_.insert(audio_.end(), samples, samples + count);
+
+    // Frame i reaches 199 samples past i * HOP, and frame 0's reflected
+    // front pad reaches sample 200.
+    while (computed_ * HOP + N_FFT / 2 < audio_.size()) compute_frame(computed_++);
+}
+
+void LogMel::compute_frame(size_t i) {
+    const size_t n = audio_.size();
+    for (size_t j = 0; j < N_FFT; ++j) {
+        // Position in the audio: the first N_FFT / 2 samples of the padded
+        // stream mirror samples 200..1, and the audio ends in zeros.
+        auto pos = static_cast<ptrdiff_t>(i * HOP + j) - static_cast<ptrdiff_t>(N_FFT / 2);
+        size_t src = static_cast<size_t>(pos < 0 ? -pos : pos);
+        buf_[j] = src < n ? audio_[src] * hann_[j] : 0.0f;
+    }
+
+    for (size_t k = 0; k < BINS; ++k) {
+        float re = Simd::dot(buf_.data(), cos_.data() + k * N_FFT, N_FFT);
+        float im = Simd::dot(buf_.data(), sin_.data() + k * N_FFT, N_FFT);
+        power_[k] = re * re + im * im;
+    }
+
+    for (size_t m = 0; m < static_cast<size_t>(n_mel_); ++m) {
+        float sum = Simd::dot(power_.data(), filters_.data() + m * BINS, BINS);
+        frames_.push_back(std::log10(std::max(sum, 1e-10f)));
+    }
+}
+
+bool LogMel::finish(MelSpectrogram& out) {
+    if (!enabled() || overflowed_ || audio_.empty()) return false;
+
+    const size_t n_len = (audio_.size() + PAD_SAMPLES) / HOP;
+    // whisper computes frames up to the one starting at the end of the
+    // padded audio; the rest see only zeros and are filled in below.
+    const size_t audio_frames = std::min(n_len, (audio_.size() + N_FFT / 2) / HOP + 1);
+    while (computed_ < audio_frames) compute_frame(computed_++);
+
+    float mmax = -10.0f;
+    for (size_t i = 0; i < audio_frames * static_cast<size_t>(n_mel_); ++i) mmax = std::max(mmax, frames_[i]);
+    const float floor = mmax - 8.0f;
+    auto norm = [floor](float v) { return (std::max(v, floor) + 4.0f) / 4.0f; };
+
+    out.n_mel = n_mel_;
+    out.n_len = static_cast<int>(n_len);
+    out.n_samples = audio_.size();
+    out.data.assign(static_cast<size_t>(n_mel_) * n_len, norm(-10.0f));
+    for (size_t i = 0; i < audio_frames; ++i) {
+        for (size_t m = 0; m < static_cast<size_t>(n_mel_); ++m) {
+            out.data[m * n_len + i] = norm(frames_[i * static_cast<size_t>(n_mel_) + m]);
+        }
+    }
+    return true;
+}
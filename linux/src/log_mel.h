@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Whisper's input features in the layout whisper_set_mel() takes:
+// [n_mel][n_len], normalised, with n_len counting the frames of the 30 s
+// of silence whisper appends to every input.
+struct MelSpectrogram {
+    std::vector<float> data;
+    int n_mel = 0;
+    int n_len = 0;
+    size_t n_samples = 0;  // audio the frames cover
+};
+
+// Whisper's log-mel spectrogram computed while 16 kHz audio arrives rather
+// than all at once before encoding. Matches whisper.cpp's
+// log_mel_spectrogram(): 400-sample Hann windows every 160 samples over
+// audio reflect-padded by 200 at the front and zero-padded at the back,
+// a 400-point DFT, the model's mel filterbank and log10. finish() computes
+// the frames that needed audio past the end, applies whisper's global
+// normalisation (clamp to max - 8, then (x + 4) / 4) and transposes.
+//
+// The filterbank should be the one stored in the model file
+// (read_model_filters()); without it, librosa's Slaney filterbank, which
+// is what those were generated from, is computed instead.
+//
+// Tables and buffers are sized in configure(); append() does not allocate.
+class LogMel {
+public:
+    static constexpr size_t N_FFT = 400;
+    static constexpr size_t HOP = 160;
+    static constexpr size_t BINS = N_FFT / 2 + 1;
+    static constexpr size_t PAD_SAMPLES = 16000 * 30;
+
+    // n_mel 0 disables. Audio past max_samples overflows the builder and
+    // finish() then fails. `filters` is n_mel rows of BINS, or null.
+    void configure(int n_mel, size_t max_samples, const std::vector<float>* filters = nullptr);
+    void reset();
+
+    void append(const float* samples, size_t count);
+
+    bool enabled() const { return n_mel_ > 0; }
+    bool overflowed() const { return overflowed_; }
+    size_t samples() const { return audio_.size(); }
+
+    bool finish(MelSpectrogram& out);
+
+    const std::vector<float>& filters() const { return filters_; }
+
+    // Reads the mel filterbank from a ggml whisper model file into `out`
+    // (n_mel rows of BINS). False if the file is not one or cannot be read.
+    static bool read_model_filters(const std::string& path, std::vector<float>& out);
+
+private:
+    int n_mel_ = 0;
+    bool model_filters_ = false;
+    size_t max_samples_ = 0;
+    bool overflowed_ = false;
+    size_t computed_ = 0;
+    std::vector<float> audio_;
+    std::vector<float> frames_;   // computed_ frames of n_mel_ log10 values
+    std::vector<float> hann_;
+    std::vector<float> cos_;      // BINS rows of N_FFT
+    std::vector<float> sin_;
+    std::vector<float> filters_;  // n_mel_ rows of BINS
+    std::vector<float> buf_;
+    std::vector<float> power_;
+
+    void compute_frame(size_t i);
+};
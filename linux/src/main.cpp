@@ -5,6 +5,7 @@
 #include "text_output.h"
 #include "model_downloader.h"
 #include "benchmark.h"
+#include "vad_eval.h"
 #include <csignal>
 #include <cstring>
 #include <cstdlib>
@@ -12,6 +13,7 @@
 #include <chrono>
 #include <sstream>
 #include <filesystem>
+#include <algorithm>
 
 namespace fs = std::filesystem;
 
@@ -25,9 +27,37 @@ static std::string handle_command(TranscriptionPipeline& pipeline, Overlay& over
     if (cmd == "status") {
         std::ostringstream ss;
         ss << (pipeline.is_recording() ? "recording" : pipeline.is_transcribing() ? "transcribing" : "idle");
-        auto* m = pipeline.model_manager().current();
-        if (m) ss << "\nmodel: " << m->name();
-        ss << "\nmode: " << (pipeline.settings().transcription_mode == TranscriptionMode::continuous ? "continuous" : "buffered");
+        if (auto m = pipeline.current_model()) ss << "\nmodel: " << m->name();
+        auto loading = pipeline.loading_model();
+        if (!loading.empty()) ss << "\nloading: " << loading;
+        auto error = pipeline.load_error();
+        if (!error.empty()) ss << "\nload_error: " << error;
+        auto& cache = pipeline.model_cache();
+        ss << "\nresident: " << cache.entries().size() << " models, " << static_cast<int>(cache.memory_mb())
+           << " of " << cache.budget_mb << " MB";
+        ss << "\nmode: " << transcription_mode_name(pipeline.settings().transcription_mode);
+        auto& audio = pipeline.audio_engine();
+        if (audio.is_prepared()) {
+            auto cs = audio.capture_stats();
+            ss << "\ncapture: " << audio.backend_name() << ", " << audio.capture_path().describe();
+            ss << "\ncapture_latency_ms: " << cs.latency_ms;
+            if (cs.overruns_reported) ss << "\ncapture_overruns: " << cs.overruns;
+            if (cs.empty_dequeues > 0) ss << "\ncapture_empty_dequeues: " << cs.empty_dequeues;
+            ss << "\ncapture_dropped: " << audio.dropped_samples();
+            ss << "\ncapture_scheduling: " << audio.capture_scheduling();
+        }
+        if (auto* silero = pipeline.audio_engine().vad().silero()) {
+            auto vs = silero->stats();
+            ss << "\nvad: silero";
+            ss << "\nvad_probability: " << vs.probability;
+            ss << "\nvad_cost_us: " << vs.mean_us << " mean, " << vs.max_us << " max per "
+               << vs.budget_us / 1000.0 << " ms window";
+            if (vs.dropped > 0) ss << "\nvad_dropped_windows: " << vs.dropped;
+        } else {
+            ss << "\nvad: " << (pipeline.settings().vad_enabled ? vad_backend_name(pipeline.audio_engine().vad().backend) : "off");
+            if (pipeline.settings().vad_adaptive)
+                ss << "\nvad_noise_floor: " << pipeline.audio_engine().vad().noise_floor();
+        }
         ss << "\ntotal: " << pipeline.perf().total();
         if (pipeline.perf().total() > 0)
             ss << "\navg_rtf: " << pipeline.perf().average_rtf();
@@ -41,11 +71,16 @@ static std::string handle_command(TranscriptionPipeline& pipeline, Overlay& over
 
     if (cmd == "models") {
         std::ostringstream ss;
-        auto* cur = pipeline.model_manager().current();
+        auto cur = pipeline.current_model();
+        auto resident = pipeline.model_cache().entries();
         for (auto& m : pipeline.model_manager().available()) {
             if (cur && cur->id == m.id) ss << "* ";
             else ss << "  ";
-            ss << m.name() << " (" << (m.size / 1000000) << " MB)\n";
+            ss << m.name() << " (" << (m.size / 1000000) << " MB)";
+            for (auto& e : resident) {
+                if (e.model.id == m.id) ss << " resident " << static_cast<int>(e.memory_mb) << " MB";
+            }
+            ss << "\n";
         }
         return ss.str();
     }
@@ -54,12 +89,21 @@ static std::string handle_command(TranscriptionPipeline& pipeline, Overlay& over
         std::string name = cmd.substr(6);
         for (auto& m : pipeline.model_manager().available()) {
             if (m.name() == name || m.id == name) {
-                try {
-                    pipeline.load_model(m);
-                    return "ok: loaded " + m.name();
-                } catch (const std::exception& e) {
-                    return std::string("error: ") + e.what();
-                }
+                if (!pipeline.load_model_async(m)) return "error: already loading " + pipeline.loading_model();
+                return "ok: loading " + m.name();
+            }
+        }
+        return "error: model not found";
+    }
+
+    if (cmd.size() > 8 && cmd.substr(0, 8) == "preload ") {
+        std::string name = cmd.substr(8);
+        for (auto& m : pipeline.model_manager().available()) {
+            if (m.name() == name || m.id == name) {
+                if (!pipeline.model_cache().fits(m))
+                    return "error: " + m.name() + " does not fit in model_cache_mb";
+                if (!pipeline.preload_model_async(m)) return "error: already loading " + pipeline.loading_model();
+                return "ok: preloading " + m.name();
             }
         }
         return "error: model not found";
@@ -75,6 +119,16 @@ static std::string handle_command(TranscriptionPipeline& pipeline, Overlay& over
         pipeline.settings().save();
         return "ok";
     }
+    if (cmd == "streaming on") {
+        pipeline.settings().transcription_mode = TranscriptionMode::streaming;
+        pipeline.settings().save();
+        return "ok";
+    }
+    if (cmd == "streaming off") {
+        pipeline.settings().transcription_mode = TranscriptionMode::continuous;
+        pipeline.settings().save();
+        return "ok";
+    }
 
     if (cmd == "mic-warm on") {
         pipeline.settings().keep_mic_warm = true;
@@ -94,7 +148,7 @@ static std::string handle_command(TranscriptionPipeline& pipeline, Overlay& over
         return "ok: " + std::to_string(pipeline.model_manager().available().size()) + " models";
     }
 
-    return "error: unknown command\ncommands: status, stop, models, model <name>, continuous on|off, mic-warm on|off, reload";
+    return "error: unknown command\ncommands: status, stop, models, model <name>, preload <name>, continuous on|off, streaming on|off, mic-warm on|off, reload";
 }
 
 static void print_usage() {
@@ -104,10 +158,16 @@ static void print_usage() {
         "run:\n"
         "  speak -model <path>          model file (.bin)\n"
         "  speak -continuous             continuous transcription mode\n"
+        "  speak -streaming              streaming mode: text while you speak\n"
         "  speak -warm                   keep mic open between recordings\n"
         "  speak -type                   output via simulated typing (default: paste)\n"
         "  speak -no-vad                 disable voice activity detection\n"
-        "  speak -device <name>          PulseAudio source (see: speak --devices)\n"
+        "  speak -silero                 use the Silero neural VAD\n"
+        "  speak -spectral               use the spectral-feature VAD\n"
+        "  speak -device <name>          PulseAudio source (see: speak --devices),\n"
+        "                                or pipewire[:<node>] for native PipeWire\n"
+        "  speak -backend <name>         pulse-stream (default), pulse-simple or pipewire\n"
+        "  speak -frame-ms <n>           capture frame length, 10-30 ms recommended\n"
         "  speak -gpu / -no-gpu          force GPU on/off\n"
         "  speak -threads <n>            inference threads\n"
         "  speak -lang <code>            language code (default: en)\n"
@@ -120,11 +180,21 @@ static void print_usage() {
         "  speak status                  query running instance\n"
         "  speak stop                    stop running instance\n"
         "  speak models                  list local models\n"
-        "  speak model <name>            switch model\n"
+        "  speak model <name>            switch model (loads in the background)\n"
+        "  speak preload <name>          keep a model loaded alongside (model_cache_mb)\n"
         "  speak continuous on|off       toggle mode\n"
+        "  speak streaming on|off        toggle streaming (off: continuous)\n"
         "\n"
         "benchmark:\n"
-        "  speak --benchmark <model>     run benchmark\n",
+        "  speak --benchmark <model> [wav...]\n"
+        "                                run benchmark; WAVs add real speech,\n"
+        "                                also timed with a dynamic audio_ctx\n"
+        "  speak --benchmark-capture [seconds] [device]\n"
+        "                                compare capture backend latency\n"
+        "  speak --benchmark-vad [seconds]\n"
+        "                                per-frame cost of each VAD backend\n"
+        "  speak --vad-eval <wav>...     score VAD backends against labelled\n"
+        "                                recordings (labels in <name>.txt)\n",
         ModelManager::models_directory().c_str()
     );
 }
@@ -208,6 +278,7 @@ static void run_daemon(TranscriptionPipeline& pipeline, const std::string& model
     control.start();
 
     pipeline.apply_vad_settings();
+    pipeline.apply_audio_settings();
 
     hotkey.set_keysyms(pipeline.settings().hotkey_keysym, pipeline.settings().send_hotkey_keysym);
 
@@ -281,6 +352,18 @@ static void run_daemon(TranscriptionPipeline& pipeline, const std::string& model
         }
     }
 
+    // Routing only uses long_model once it is resident.
+    const auto& long_model = pipeline.settings().long_model;
+    for (auto& m : pipeline.model_manager().available()) {
+        if (long_model.empty() || (m.name() != long_model && m.id != long_model)) continue;
+        if (pipeline.model_cache().fits(m)) {
+            pipeline.preload_model_async(m);
+        } else {
+            fprintf(stderr, "[main] long_model %s does not fit in model_cache_mb (%d MB), not preloading\n",
+                    m.name().c_str(), pipeline.settings().model_cache_mb);
+        }
+    }
+
     fprintf(stderr, "[main] Ready — F12 hold-to-talk, F11 hold-to-talk+return, Ctrl+C to quit\n");
 
     while (g_running) {
@@ -295,10 +378,26 @@ static void run_daemon(TranscriptionPipeline& pipeline, const std::string& model
 
 int main(int argc, char* argv[]) {
     if (argc >= 3 && std::strcmp(argv[1], "--benchmark") == 0) {
-        run_benchmark(argv[2]);
+        run_benchmark(argv[2], std::vector<std::string>(argv + 3, argv + argc));
         return 0;
     }
 
+    if (argc >= 2 && std::strcmp(argv[1], "--benchmark-capture") == 0) {
+        int seconds = argc >= 3 ? std::max(1, std::atoi(argv[2])) : 5;
+        std::string dev = argc >= 4 ? argv[3] : "";
+        run_capture_benchmark(dev, seconds, Settings::load().capture_frame_ms);
+        return 0;
+    }
+
+    if (argc >= 2 && std::strcmp(argv[1], "--benchmark-vad") == 0) {
+        run_vad_benchmark(argc >= 3 ? std::max(5, std::atoi(argv[2])) : 60);
+        return 0;
+    }
+
+    if (argc >= 3 && std::strcmp(argv[1], "--vad-eval") == 0) {
+        return run_vad_eval(std::vector<std::string>(argv + 2, argv + argc));
+    }
+
     if (argc >= 2 && std::strcmp(argv[1], "--remote-models") == 0) {
         return cmd_remote_models();
     }
@@ -344,6 +443,8 @@ int main(int argc, char* argv[]) {
             model_path = argv[++i];
         } else if (std::strcmp(argv[i], "-continuous") == 0 || std::strcmp(argv[i], "--continuous") == 0) {
             pipeline.settings().transcription_mode = TranscriptionMode::continuous;
+        } else if (std::strcmp(argv[i], "-streaming") == 0 || std::strcmp(argv[i], "--streaming") == 0) {
+            pipeline.settings().transcription_mode = TranscriptionMode::streaming;
         } else if (std::strcmp(argv[i], "-buffered") == 0 || std::strcmp(argv[i], "--buffered") == 0) {
             pipeline.settings().transcription_mode = TranscriptionMode::buffered;
         } else if (std::strcmp(argv[i], "-warm") == 0 || std::strcmp(argv[i], "--warm") == 0) {
@@ -364,8 +465,19 @@ int main(int argc, char* argv[]) {
             pipeline.settings().language = argv[++i];
         } else if (std::strcmp(argv[i], "-no-vad") == 0 || std::strcmp(argv[i], "--no-vad") == 0) {
             pipeline.settings().vad_enabled = false;
+        } else if (std::strcmp(argv[i], "-silero") == 0 || std::strcmp(argv[i], "--silero") == 0) {
+            pipeline.settings().vad_backend = VadBackend::silero;
+        } else if (std::strcmp(argv[i], "-spectral") == 0 || std::strcmp(argv[i], "--spectral") == 0) {
+            pipeline.settings().vad_backend = VadBackend::spectral;
         } else if ((std::strcmp(argv[i], "-device") == 0 || std::strcmp(argv[i], "--device") == 0) && i + 1 < argc) {
             pipeline.audio_engine().device = argv[++i];
+        } else if ((std::strcmp(argv[i], "-backend") == 0 || std::strcmp(argv[i], "--backend") == 0) && i + 1 < argc) {
+            ++i;
+            if (std::strcmp(argv[i], "pulse-simple") == 0) pipeline.settings().audio_backend = AudioBackend::pulse_simple;
+            else if (std::strcmp(argv[i], "pulse-stream") == 0) pipeline.settings().audio_backend = AudioBackend::pulse_stream;
+            else if (std::strcmp(argv[i], "pipewire") == 0) pipeline.settings().audio_backend = AudioBackend::pipewire;
+        } else if ((std::strcmp(argv[i], "-frame-ms") == 0 || std::strcmp(argv[i], "--frame-ms") == 0) && i + 1 < argc) {
+            pipeline.settings().capture_frame_ms = std::atoi(argv[++i]);
         }
     }
 
@@ -0,0 +1,107 @@
+#include "model_cache.h"
+#include "performance_monitor.h"
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+
+std::shared_ptr<WhisperContext> ModelCache::get(const std::string& model) {
+    std::lock_guard<std::mutex> lk(mu_);
+    for (auto& s : slots_) {
+        if (s.model.id == model || s.model.name() == model) {
+            s.used = ++clock_;
+            return s.ctx;
+        }
+    }
+    return nullptr;
+}
+
+std::shared_ptr<WhisperContext> ModelCache::load(const WhisperModel& model, const Settings& settings, bool pin) {
+    std::lock_guard<std::mutex> load_lk(load_mu_);
+    if (auto ctx = get(model.id)) {
+        if (pin) this->pin(model.id);
+        return ctx;
+    }
+    if (!pin && !fits(model)) {
+        throw std::runtime_error(model.name() + " does not fit in model_cache_mb (" +
+                                 std::to_string(budget_mb) + " MB)");
+    }
+
+    double before = PerformanceMonitor::resident_memory_mb();
+    auto ctx = std::make_shared<WhisperContext>(model.path, settings);
+    ctx->warmup();
+    double memory = std::max(PerformanceMonitor::resident_memory_mb() - before,
+                             static_cast<double>(model.size) / 1e6);
+
+    std::vector<std::shared_ptr<WhisperContext>> evicted;
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        slots_.push_back({model, ctx, memory, ++clock_});
+        if (pin) pinned_ = model.id;
+        evicted = evict();
+    }
+    fprintf(stderr, "[ModelCache] Loaded %s (%.0f MB, %zu resident)\n",
+            model.name().c_str(), memory, entries().size());
+    return ctx;
+}
+
+bool ModelCache::fits(const WhisperModel& model) const {
+    std::lock_guard<std::mutex> lk(mu_);
+    double pinned = 0;
+    for (auto& s : slots_) {
+        if (s.model.id == pinned_) pinned = s.memory_mb;
+    }
+    return pinned + static_cast<double>(model.size) / 1e6 <= static_cast<double>(budget_mb);
+}
+
+void ModelCache::pin(const std::string& id) {
+    std::vector<std::shared_ptr<WhisperContext>> evicted;
+    std::lock_guard<std::mutex> lk(mu_);
+    pinned_ = id;
+    evicted = evict();
+}
+
+void ModelCache::clear() {
+    std::vector<Slot> slots;
+    std::lock_guard<std::mutex> lk(mu_);
+    slots.swap(slots_);
+    pinned_.clear();
+}
+
+std::vector<ModelCache::Entry> ModelCache::entries() const {
+    std::vector<const Slot*> order;
+    std::lock_guard<std::mutex> lk(mu_);
+    for (auto& s : slots_) order.push_back(&s);
+    std::sort(order.begin(), order.end(), [](const Slot* a, const Slot* b) { return a->used > b->used; });
+
+    std::vector<Entry> out;
+    for (auto* s : order) out.push_back({s->model, s->memory_mb, s->model.id == pinned_});
+    return out;
+}
+
+double ModelCache::memory_mb() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    double total = 0;
+    for (auto& s : slots_) total += s.memory_mb;
+    return total;
+}
+
+std::vector<std::shared_ptr<WhisperContext>> ModelCache::evict() {
+    std::vector<std::shared_ptr<WhisperContext>> evicted;
+    double total = 0;
+    for (auto& s : slots_) total += s.memory_mb;
+
+    while (total > static_cast<double>(std::max(0, budget_mb))) {
+        auto lru = slots_.end();
+        for (auto it = slots_.begin(); it != slots_.end(); ++it) {
+            if (it->model.id == pinned_) continue;
+            if (lru == slots_.end() || it->used < lru->used) lru = it;
+        }
+        if (lru == slots_.end()) break;
+
+        fprintf(stderr, "[ModelCache] Evicted %s (%.0f MB)\n", lru->model.name().c_str(), lru->memory_mb);
+        total -= lru->memory_mb;
+        evicted.push_back(std::move(lru->ctx));
+        slots_.erase(lru);
+    }
+    return evicted;
+}
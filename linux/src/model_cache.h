@@ -0,0 +1,76 @@
+#pragma once
+
+#include "model_manager.h"
+#include "whisper_context.h"
+#include "settings.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Whisper models kept loaded side by side, keyed by model id, so switching
+// to one or routing a job to it costs no load. Each model is charged what
+// its load and warmup added to the process's resident memory, and at least
+// its file size (weights on the GPU do not show up in RSS). The charge is
+// approximate: other threads allocate meanwhile, and whisper states a
+// model creates after warmup are not counted. When the total
+// passes budget_mb the least recently used models are dropped, never the
+// pinned one (the model the pipeline is switched to). A dropped model that
+// a job still holds is freed when the job ends, and is no longer counted.
+class ModelCache {
+public:
+    struct Entry {
+        WhisperModel model;
+        double memory_mb;
+        bool pinned;
+    };
+
+    // 0 keeps only the pinned model.
+    int budget_mb = 0;
+
+    ModelCache() = default;
+    ModelCache(const ModelCache&) = delete;
+    ModelCache& operator=(const ModelCache&) = delete;
+
+    // The resident model with this id or display name, marked as used;
+    // null if it is not loaded.
+    std::shared_ptr<WhisperContext> get(const std::string& model);
+
+    // Returns the resident context for `model`, loading and warming it
+    // first if needed. Loads run one at a time, so each is measured alone.
+    // Throws if the model fails to load, or is not pinned and does not fit.
+    std::shared_ptr<WhisperContext> load(const WhisperModel& model, const Settings& settings, bool pin);
+
+    // Whether `model` can stay loaded next to the pinned one, going by its
+    // file size. Unpinned loads that cannot are refused, since the model
+    // would be evicted as soon as it was warm.
+    bool fits(const WhisperModel& model) const;
+
+    // Protects `id` from eviction in place of the previous pinned model,
+    // which then competes for the budget like the rest.
+    void pin(const std::string& id);
+    void clear();
+
+    // Most recently used first.
+    std::vector<Entry> entries() const;
+    double memory_mb() const;
+
+private:
+    struct Slot {
+        WhisperModel model;
+        std::shared_ptr<WhisperContext> ctx;
+        double memory_mb;
+        uint64_t used;
+    };
+
+    mutable std::mutex mu_;
+    std::mutex load_mu_;
+    std::vector<Slot> slots_;
+    std::string pinned_;
+    uint64_t clock_ = 0;
+
+    // Takes the evicted contexts out under mu_; they are freed by the
+    // caller after unlocking.
+    std::vector<std::shared_ptr<WhisperContext>> evict();
+};
@@ -53,6 +53,27 @@ std::string ModelManager::models_directory() {
     return std::string(home ? home : ".") + "/.local/share/speak/models";
 }
 
+static const char* VAD_FILENAME = "ggml-silero-v6.2.0.bin";
+
+std::string ModelManager::vad_model_path() {
+    std::error_code ec;
+    fs::path exe_dir = fs::read_symlink("/proc/self/exe", ec).parent_path();
+
+    // Installed model first, then the copy shipped in Resources/models,
+    // found from the working directory or from a build dir under linux/.
+    std::vector<fs::path> dirs = {
+        models_directory(),
+        fs::current_path(ec) / "Resources/models",
+    };
+    if (!exe_dir.empty()) dirs.push_back(exe_dir / "../../Resources/models");
+
+    for (auto& dir : dirs) {
+        fs::path p = dir / VAD_FILENAME;
+        if (fs::is_regular_file(p, ec)) return fs::weakly_canonical(p, ec).string();
+    }
+    return {};
+}
+
 static std::string config_dir() {
     const char* xdg = std::getenv("XDG_CONFIG_HOME");
     if (xdg && xdg[0]) return std::string(xdg) + "/speak";
@@ -81,9 +102,7 @@ ModelManager::ModelManager() {
 }
 
 void ModelManager::scan() {
-    models_.clear();
-    current_idx_ = -1;
-
+    std::vector<WhisperModel> found;
     std::string dir = models_directory();
     fs::create_directories(dir);
 
@@ -91,36 +110,41 @@ void ModelManager::scan() {
     for (auto& entry : fs::directory_iterator(dir, ec)) {
         if (!entry.is_regular_file()) continue;
         if (entry.path().extension() != ".bin") continue;
+        if (entry.path().filename().string().rfind("ggml-silero", 0) == 0) continue;
 
         WhisperModel m;
         m.id = entry.path().stem().string();
         m.path = entry.path().string();
         m.size = static_cast<int64_t>(entry.file_size());
-        models_.push_back(std::move(m));
+        found.push_back(std::move(m));
     }
 
-    std::sort(models_.begin(), models_.end(),
+    std::sort(found.begin(), found.end(),
               [](const WhisperModel& a, const WhisperModel& b) { return a.size < b.size; });
+    std::lock_guard<std::mutex> lk(mu_);
+    models_.swap(found);
 }
 
-std::unique_ptr<WhisperContext> ModelManager::load(const WhisperModel& model, const Settings& settings) {
-    auto ctx = std::make_unique<WhisperContext>(model.path, settings);
-
-    for (int i = 0; i < static_cast<int>(models_.size()); ++i) {
-        if (models_[i].id == model.id) { current_idx_ = i; break; }
+std::optional<WhisperModel> ModelManager::current() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    for (auto& m : models_) {
+        if (m.id == current_) return m;
     }
+    return std::nullopt;
+}
 
-    save_selection(model.id);
-    return ctx;
+void ModelManager::select(const std::string& id) {
+    std::lock_guard<std::mutex> lk(mu_);
+    current_ = id;
+    save_selection(id);
 }
 
-std::unique_ptr<WhisperContext> ModelManager::load_saved_or_first(const Settings& settings) {
+const WhisperModel* ModelManager::saved_or_first() const {
     std::string saved = load_selection();
     if (!saved.empty()) {
         for (auto& m : models_) {
-            if (m.id == saved) return load(m, settings);
+            if (m.id == saved) return &m;
         }
     }
-    if (models_.empty()) throw std::runtime_error("No models found");
-    return load(models_.front(), settings);
+    return models_.empty() ? nullptr : &models_.front();
 }
@@ -1,10 +1,10 @@
 #pragma once
 
-#include "whisper_context.h"
-#include "settings.h"
 #include <string>
 #include <vector>
-#include <memory>
+#include <cstdint>
+#include <mutex>
+#include <optional>
 
 struct WhisperModel {
     std::string id;
@@ -19,22 +19,32 @@ class ModelManager {
 public:
     ModelManager();
 
+    // scan() and available() belong to the control thread; select() and
+    // current() may be called from any, e.g. by a model loader.
     void scan();
     const std::vector<WhisperModel>& available() const { return models_; }
-    const WhisperModel* current() const { return current_idx_ >= 0 ? &models_[current_idx_] : nullptr; }
+    // The selected model, if the last scan found it.
+    std::optional<WhisperModel> current() const;
 
-    std::unique_ptr<WhisperContext> load(const WhisperModel& model, const Settings& settings);
-    std::unique_ptr<WhisperContext> load_saved_or_first(const Settings& settings);
+    // Marks `id` as the current model and saves it as the selection.
+    void select(const std::string& id);
+    // The saved selection if it is still available, else the smallest
+    // model; null if there are none.
+    const WhisperModel* saved_or_first() const;
 
     static std::string models_directory();
+    // Bundled Silero VAD model; empty if it cannot be found.
+    static std::string vad_model_path();
 
 private:
     std::vector<WhisperModel> models_;
-    int current_idx_ = -1;
+    std::string current_;
+    mutable std::mutex mu_;  // current_, and models_ while scan() replaces it
 
     static std::string saved_model_path();
-    void save_selection(const std::string& id);
-    std::string load_selection();
+    // Makes `id` the model saved_or_first() picks next time.
+    static void save_selection(const std::string& id);
+    static std::string load_selection();
 };
 
 namespace ModelNameFormatter {
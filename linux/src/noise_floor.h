@@ -0,0 +1,62 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <limits>
+
+// Background level estimate by minimum statistics: the minimum of the
+// smoothed frame RMS over a sliding window, kept as SUBWINDOWS running
+// minima so each update is O(1). Speech raises the smoothed level but not
+// its minimum across a few seconds, since even continuous speech has gaps
+// between words, so the floor follows the room rather than the talker.
+class NoiseFloorTracker {
+public:
+    static constexpr int SUBWINDOWS = 8;
+    static constexpr int FRAMES_PER_SUBWINDOW = 25;  // 0.75 s of 30 ms frames
+    static constexpr float SMOOTHING = 0.8f;
+
+    void reset() {
+        smoothed_ = 0;
+        current_min_ = INF;
+        frames_ = 0;
+        filled_ = 0;
+        next_ = 0;
+        floor_ = 0;
+    }
+
+    // Feeds one frame's RMS; returns the current floor.
+    float update(float rms) {
+        smoothed_ = (filled_ == 0 && frames_ == 0) ? rms : SMOOTHING * smoothed_ + (1.0f - SMOOTHING) * rms;
+        current_min_ = std::min(current_min_, smoothed_);
+
+        if (++frames_ == FRAMES_PER_SUBWINDOW) {
+            minima_[next_] = current_min_;
+            next_ = (next_ + 1) % SUBWINDOWS;
+            filled_ = std::min(filled_ + 1, SUBWINDOWS);
+            current_min_ = INF;
+            frames_ = 0;
+        }
+
+        if (filled_ > 0) {
+            float m = current_min_;
+            for (int i = 0; i < filled_; ++i) m = std::min(m, minima_[i]);
+            floor_ = m;
+        }
+        return floor_;
+    }
+
+    // 0 until the first subwindow has completed.
+    float floor() const { return floor_; }
+    bool ready() const { return filled_ > 0; }
+
+private:
+    static constexpr float INF = std::numeric_limits<float>::infinity();
+
+    std::array<float, SUBWINDOWS> minima_{};
+    float smoothed_ = 0;
+    float current_min_ = INF;
+    int frames_ = 0;
+    int filled_ = 0;
+    int next_ = 0;
+    float floor_ = 0;
+};
@@ -0,0 +1,158 @@
+#include "pipewire_capture.h"
+#include <pipewire/pipewire.h>
+#include <spa/param/audio/format-utils.h>
+#include <cstdio>
+#include <mutex>
+
+struct PipeWireEvents {
+    static void state_changed(void* data, pw_stream_state, pw_stream_state state, const char* error) {
+        auto* me = static_cast<PipeWireCapture*>(data);
+        if (state == PW_STREAM_STATE_ERROR) {
+            fprintf(stderr, "[PipeWire] stream error: %s\n", error ? error : "unknown");
+            me->failed_ = true;
+        }
+        pw_thread_loop_signal(me->loop_, false);
+    }
+
+    static void param_changed(void* data, uint32_t id, const spa_pod* param) {
+        auto* me = static_cast<PipeWireCapture*>(data);
+        if (!param || id != SPA_PARAM_Format) return;
+
+        uint32_t media_type = 0, media_subtype = 0;
+        if (spa_format_parse(param, &media_type, &media_subtype) < 0) return;
+        if (media_type != SPA_MEDIA_TYPE_audio || media_subtype != SPA_MEDIA_SUBTYPE_raw) return;
+
+        spa_audio_info_raw info{};
+        if (spa_format_audio_raw_parse(param, &info) < 0) return;
+        me->spec_.rate = info.rate;
+        me->spec_.format = info.format == SPA_AUDIO_FORMAT_S16 ? SampleFormat::s16 : SampleFormat::f32;
+        me->format_ready_ = true;
+        pw_thread_loop_signal(me->loop_, false);
+    }
+
+    static void process(void* data) {
+        auto* me = static_cast<PipeWireCapture*>(data);
+        pw_buffer* b = pw_stream_dequeue_buffer(me->stream_);
+        if (!b) {
+            me->empty_dequeues_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        spa_data& d = b->buffer->datas[0];
+        if (d.data && d.chunk && me->format_ready_) {
+            const char* base = static_cast<const char*>(d.data) + d.chunk->offset;
+            size_t frames = d.chunk->size / sample_size(me->spec_.format);
+            me->on_frames_(base, frames);
+        }
+        pw_stream_queue_buffer(me->stream_, b);
+
+        uint64_t n = me->callbacks_.fetch_add(1, std::memory_order_relaxed);
+        if (n % 16 == 0) {
+            pw_time t{};
+            if (pw_stream_get_time_n(me->stream_, &t, sizeof(t)) == 0 && t.rate.denom > 0) {
+                double us = static_cast<double>(t.delay) * 1e6 * t.rate.num / t.rate.denom;
+                me->latency_us_.store(us > 0 ? static_cast<uint64_t>(us) : 0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    static const pw_stream_events& events() {
+        static const pw_stream_events ev = [] {
+            pw_stream_events e{};
+            e.version = PW_VERSION_STREAM_EVENTS;
+            e.state_changed = state_changed;
+            e.param_changed = param_changed;
+            e.process = process;
+            return e;
+        }();
+        return ev;
+    }
+};
+
+PipeWireCapture::~PipeWireCapture() {
+    close();
+}
+
+bool PipeWireCapture::open(const std::string& device, CaptureSpec& spec, int frame_ms, Callback on_frames) {
+    if (stream_) return true;
+
+    static std::once_flag init;
+    std::call_once(init, [] { pw_init(nullptr, nullptr); });
+
+    on_frames_ = std::move(on_frames);
+    spec_ = spec;
+    format_ready_ = false;
+    failed_ = false;
+
+    loop_ = pw_thread_loop_new("speak-capture", nullptr);
+    if (!loop_) return false;
+
+    pw_properties* props = pw_properties_new(
+        PW_KEY_MEDIA_TYPE, "Audio",
+        PW_KEY_MEDIA_CATEGORY, "Capture",
+        PW_KEY_MEDIA_ROLE, "Communication",
+        nullptr);
+    if (!device.empty()) pw_properties_set(props, PW_KEY_TARGET_OBJECT, device.c_str());
+    pw_properties_setf(props, PW_KEY_NODE_LATENCY, "%u/%u",
+                       spec.rate * static_cast<uint32_t>(frame_ms) / 1000, spec.rate);
+
+    pw_thread_loop_lock(loop_);
+    stream_ = pw_stream_new_simple(pw_thread_loop_get_loop(loop_), "speak", props,
+                                   &PipeWireEvents::events(), this);
+
+    bool ok = stream_ != nullptr;
+    if (ok) {
+        uint8_t pod_buf[1024];
+        spa_pod_builder b{};
+        spa_pod_builder_init(&b, pod_buf, sizeof(pod_buf));
+
+        spa_audio_info_raw info{};
+        info.format = spec.format == SampleFormat::s16 ? SPA_AUDIO_FORMAT_S16 : SPA_AUDIO_FORMAT_F32;
+        info.rate = spec.rate;
+        info.channels = 1;
+        info.position[0] = SPA_AUDIO_CHANNEL_MONO;
+
+        const spa_pod* params[1];
+        params[0] = spa_format_audio_raw_build(&b, SPA_PARAM_EnumFormat, &info);
+
+        auto flags = static_cast<pw_stream_flags>(
+            PW_STREAM_FLAG_AUTOCONNECT | PW_STREAM_FLAG_MAP_BUFFERS | PW_STREAM_FLAG_RT_PROCESS);
+        ok = pw_stream_connect(stream_, PW_DIRECTION_INPUT, PW_ID_ANY, flags, params, 1) >= 0
+          && pw_thread_loop_start(loop_) >= 0;
+    }
+
+    // Wait for the graph to settle on a format; 2 s is plenty for a local
+    // session manager and keeps a misconfigured one from hanging startup.
+    while (ok && !format_ready_ && !failed_) {
+        if (pw_thread_loop_timed_wait(loop_, 2) != 0) {
+            fprintf(stderr, "[PipeWire] timed out waiting for stream format\n");
+            ok = false;
+        }
+    }
+    ok = ok && !failed_;
+    if (ok) spec = spec_;
+    pw_thread_loop_unlock(loop_);
+
+    if (!ok) close();
+    return ok;
+}
+
+void PipeWireCapture::close() {
+    if (!loop_) return;
+
+    pw_thread_loop_stop(loop_);
+    if (stream_) {
+        pw_stream_destroy(stream_);
+        stream_ = nullptr;
+    }
+    pw_thread_loop_destroy(loop_);
+    loop_ = nullptr;
+}
+
+CaptureStats PipeWireCapture::stats() const {
+    CaptureStats s;
+    s.callbacks = callbacks_.load(std::memory_order_relaxed);
+    s.empty_dequeues = empty_dequeues_.load(std::memory_order_relaxed);
+    s.latency_ms = static_cast<double>(latency_us_.load(std::memory_order_relaxed)) / 1000.0;
+    return s;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "capture_backend.h"
+#include <atomic>
+#include <cstdint>
+
+struct pw_thread_loop;
+struct pw_stream;
+
+// Native PipeWire capture stream. process() runs once per graph quantum on
+// PipeWire's data thread, and node.latency asks the graph for a quantum of
+// frame_ms, so there is no pulse-compat hop and no extra buffering.
+class PipeWireCapture : public CaptureBackend {
+public:
+    ~PipeWireCapture() override;
+
+    bool open(const std::string& device, CaptureSpec& spec, int frame_ms, Callback on_frames) override;
+    void close() override;
+    const char* name() const override { return "pipewire"; }
+    CaptureStats stats() const override;
+
+private:
+    pw_thread_loop* loop_ = nullptr;
+    pw_stream* stream_ = nullptr;
+    CaptureSpec spec_;
+    Callback on_frames_;
+    std::atomic<bool> format_ready_{false};
+    std::atomic<bool> failed_{false};
+    std::atomic<uint64_t> callbacks_{0};
+    // The stream API does not report capture xruns (the graph driver
+    // handles them), so only empty dequeues are counted.
+    std::atomic<uint64_t> empty_dequeues_{0};
+    std::atomic<uint64_t> latency_us_{0};
+
+    friend struct PipeWireEvents;
+};
@@ -0,0 +1,309 @@
+#include "pulse_capture.h"
+#include <pulse/simple.h>
+#include <pulse/error.h>
+#include <pulse/pulseaudio.h>
+#include <cstdio>
+#include <ctime>
+#include <vector>
+
+static pa_sample_spec to_pa_spec(const CaptureSpec& spec) {
+    pa_sample_spec ss{};
+    ss.format = spec.format == SampleFormat::s16 ? PA_SAMPLE_S16LE : PA_SAMPLE_FLOAT32LE;
+    ss.channels = 1;
+    ss.rate = spec.rate;
+    return ss;
+}
+
+static void source_info_cb(pa_context*, const pa_source_info* info, int eol, void* userdata) {
+    if (eol || !info) return;
+    auto* out = static_cast<std::vector<std::pair<std::string,std::string>>*>(userdata);
+    std::string desc = info->description ? info->description : "";
+    out->push_back({info->name, desc});
+}
+
+static void source_spec_cb(pa_context*, const pa_source_info* info, int eol, void* userdata) {
+    if (eol || !info) return;
+    *static_cast<pa_sample_spec*>(userdata) = info->sample_spec;
+}
+
+static void server_info_cb(pa_context*, const pa_server_info* info, void* userdata) {
+    if (!info || !info->default_source_name) return;
+    *static_cast<std::string*>(userdata) = info->default_source_name;
+}
+
+static void run_operation(pa_mainloop* ml, pa_operation* op) {
+    if (!op) return;
+    while (pa_operation_get_state(op) == PA_OPERATION_RUNNING) {
+        pa_mainloop_iterate(ml, 1, nullptr);
+    }
+    pa_operation_unref(op);
+}
+
+static pa_context* connect_context(pa_mainloop* ml, const char* name) {
+    pa_context* ctx = pa_context_new(pa_mainloop_get_api(ml), name);
+    pa_context_connect(ctx, nullptr, PA_CONTEXT_NOFLAGS, nullptr);
+
+    for (int i = 0; i < 100; ++i) {
+        pa_mainloop_iterate(ml, 0, nullptr);
+        if (pa_context_get_state(ctx) == PA_CONTEXT_READY) return ctx;
+        if (pa_context_get_state(ctx) == PA_CONTEXT_FAILED) break;
+        struct timespec ts{0, 10000000};
+        nanosleep(&ts, nullptr);
+    }
+
+    pa_context_unref(ctx);
+    return nullptr;
+}
+
+static void disconnect_context(pa_context* ctx) {
+    pa_context_disconnect(ctx);
+    pa_context_unref(ctx);
+}
+
+void PulseCapture::list_sources() {
+    pa_mainloop* ml = pa_mainloop_new();
+    pa_context* ctx = connect_context(ml, "speak-list");
+    if (!ctx) {
+        fprintf(stderr, "Cannot connect to PulseAudio/PipeWire\n");
+        pa_mainloop_free(ml);
+        return;
+    }
+
+    std::vector<std::pair<std::string,std::string>> sources;
+    run_operation(ml, pa_context_get_source_info_list(ctx, source_info_cb, &sources));
+
+    for (auto& [name, desc] : sources) {
+        fprintf(stderr, "  %-60s  %s\n", name.c_str(), desc.c_str());
+    }
+
+    disconnect_context(ctx);
+    pa_mainloop_free(ml);
+}
+
+bool PulseCapture::query_source_spec(const std::string& device, CaptureSpec& out) {
+    pa_mainloop* ml = pa_mainloop_new();
+    pa_context* ctx = connect_context(ml, "speak-probe");
+    if (!ctx) {
+        pa_mainloop_free(ml);
+        return false;
+    }
+
+    std::string name = device;
+    if (name.empty()) run_operation(ml, pa_context_get_server_info(ctx, server_info_cb, &name));
+
+    pa_sample_spec native{};
+    native.format = PA_SAMPLE_INVALID;
+    if (!name.empty()) {
+        run_operation(ml, pa_context_get_source_info_by_name(ctx, name.c_str(), source_spec_cb, &native));
+    }
+
+    disconnect_context(ctx);
+    pa_mainloop_free(ml);
+
+    if (native.format == PA_SAMPLE_INVALID || native.rate == 0) return false;
+    out.rate = native.rate;
+    out.format = native.format == PA_SAMPLE_S16LE ? SampleFormat::s16 : SampleFormat::f32;
+    return true;
+}
+
+// --- pa_simple ---
+
+PulseSimpleCapture::~PulseSimpleCapture() {
+    close();
+}
+
+bool PulseSimpleCapture::open(const std::string& device, CaptureSpec& spec, int frame_ms, Callback on_frames) {
+    if (pa_) return true;
+
+    pa_sample_spec ss = to_pa_spec(spec);
+    const char* dev = device.empty() ? nullptr : device.c_str();
+
+    int err = 0;
+    pa_ = pa_simple_new(nullptr, "speak", PA_STREAM_RECORD, dev,
+                         "capture", &ss, nullptr, nullptr, &err);
+    if (!pa_) {
+        fprintf(stderr, "[PulseSimple] pa_simple_new failed: %s\n", pa_strerror(err));
+        return false;
+    }
+
+    spec_ = spec;
+    frame_ = static_cast<size_t>(spec.rate) * static_cast<size_t>(frame_ms) / 1000;
+    on_frames_ = std::move(on_frames);
+    running_ = true;
+    thread_ = std::thread(&PulseSimpleCapture::read_loop, this);
+    return true;
+}
+
+void PulseSimpleCapture::close() {
+    running_ = false;
+    if (thread_.joinable()) thread_.join();
+    if (pa_) {
+        pa_simple_free(pa_);
+        pa_ = nullptr;
+    }
+}
+
+CaptureStats PulseSimpleCapture::stats() const {
+    CaptureStats s;
+    s.callbacks = callbacks_.load(std::memory_order_relaxed);
+    s.latency_ms = static_cast<double>(latency_us_.load(std::memory_order_relaxed)) / 1000.0;
+    return s;
+}
+
+void PulseSimpleCapture::read_loop() {
+    std::vector<char> buf(frame_ * sample_size(spec_.format));
+    int err = 0;
+    while (running_) {
+        if (pa_simple_read(pa_, buf.data(), buf.size(), &err) < 0) {
+            fprintf(stderr, "[PulseSimple] read error: %s\n", pa_strerror(err));
+            break;
+        }
+        uint64_t n = callbacks_.fetch_add(1, std::memory_order_relaxed);
+        on_frames_(buf.data(), frame_);
+
+        // get_latency is a server round trip; sample it about once a second.
+        if (n % 32 == 0) {
+            pa_usec_t lat = pa_simple_get_latency(pa_, &err);
+            if (lat != static_cast<pa_usec_t>(-1)) latency_us_.store(lat, std::memory_order_relaxed);
+        }
+    }
+}
+
+// --- pa_stream ---
+
+PulseStreamCapture::~PulseStreamCapture() {
+    close();
+}
+
+void PulseStreamCapture::context_state_cb(pa_context*, void* self) {
+    pa_threaded_mainloop_signal(static_cast<PulseStreamCapture*>(self)->ml_, 0);
+}
+
+void PulseStreamCapture::stream_state_cb(pa_stream*, void* self) {
+    pa_threaded_mainloop_signal(static_cast<PulseStreamCapture*>(self)->ml_, 0);
+}
+
+void PulseStreamCapture::overflow_cb(pa_stream*, void* self) {
+    static_cast<PulseStreamCapture*>(self)->overruns_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PulseStreamCapture::read_cb(pa_stream* s, size_t, void* self) {
+    auto* me = static_cast<PulseStreamCapture*>(self);
+
+    const void* data = nullptr;
+    size_t nbytes = 0;
+    while (pa_stream_peek(s, &data, &nbytes) == 0 && nbytes > 0) {
+        // A null pointer with a length is a hole in the stream (data lost
+        // server side); skip it like an overrun.
+        if (data) {
+            me->on_frames_(data, nbytes / me->frame_bytes_);
+        } else {
+            me->overruns_.fetch_add(1, std::memory_order_relaxed);
+        }
+        pa_stream_drop(s);
+        me->callbacks_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    pa_usec_t lat = 0;
+    int negative = 0;
+    if (pa_stream_get_latency(s, &lat, &negative) == 0) {
+        me->latency_us_.store(negative ? 0 : lat, std::memory_order_relaxed);
+    }
+}
+
+bool PulseStreamCapture::open(const std::string& device, CaptureSpec& spec, int frame_ms, Callback on_frames) {
+    if (stream_) return true;
+
+    on_frames_ = std::move(on_frames);
+    pa_sample_spec ss = to_pa_spec(spec);
+    frame_bytes_ = sample_size(spec.format);
+
+    ml_ = pa_threaded_mainloop_new();
+    ctx_ = pa_context_new(pa_threaded_mainloop_get_api(ml_), "speak");
+    pa_context_set_state_callback(ctx_, context_state_cb, this);
+
+    pa_threaded_mainloop_lock(ml_);
+    bool ok = pa_context_connect(ctx_, nullptr, PA_CONTEXT_NOFLAGS, nullptr) >= 0
+           && pa_threaded_mainloop_start(ml_) >= 0;
+
+    while (ok) {
+        pa_context_state_t st = pa_context_get_state(ctx_);
+        if (st == PA_CONTEXT_READY) break;
+        if (!PA_CONTEXT_IS_GOOD(st)) ok = false;
+        else pa_threaded_mainloop_wait(ml_);
+    }
+
+    if (ok) {
+        stream_ = pa_stream_new(ctx_, "capture", &ss, nullptr);
+        ok = stream_ != nullptr;
+    }
+
+    if (ok) {
+        pa_stream_set_state_callback(stream_, stream_state_cb, this);
+        pa_stream_set_read_callback(stream_, read_cb, this);
+        pa_stream_set_overflow_callback(stream_, overflow_cb, this);
+
+        pa_buffer_attr attr{};
+        attr.maxlength = static_cast<uint32_t>(-1);
+        attr.tlength = static_cast<uint32_t>(-1);
+        attr.prebuf = static_cast<uint32_t>(-1);
+        attr.minreq = static_cast<uint32_t>(-1);
+        attr.fragsize = static_cast<uint32_t>(pa_usec_to_bytes(static_cast<pa_usec_t>(frame_ms) * 1000, &ss));
+
+        auto flags = static_cast<pa_stream_flags_t>(
+            PA_STREAM_ADJUST_LATENCY | PA_STREAM_AUTO_TIMING_UPDATE | PA_STREAM_INTERPOLATE_TIMING);
+        const char* dev = device.empty() ? nullptr : device.c_str();
+        ok = pa_stream_connect_record(stream_, dev, &attr, flags) >= 0;
+    }
+
+    while (ok) {
+        pa_stream_state_t st = pa_stream_get_state(stream_);
+        if (st == PA_STREAM_READY) break;
+        if (!PA_STREAM_IS_GOOD(st)) ok = false;
+        else pa_threaded_mainloop_wait(ml_);
+    }
+
+    if (ok) {
+        const pa_buffer_attr* got = pa_stream_get_buffer_attr(stream_);
+        if (got) {
+            fprintf(stderr, "[PulseStream] fragsize %u bytes (%.1f ms)\n", got->fragsize,
+                    static_cast<double>(got->fragsize) / static_cast<double>(frame_bytes_) * 1000.0 / spec.rate);
+        }
+    } else {
+        fprintf(stderr, "[PulseStream] connect failed: %s\n", pa_strerror(pa_context_errno(ctx_)));
+    }
+    pa_threaded_mainloop_unlock(ml_);
+
+    if (!ok) close();
+    return ok;
+}
+
+void PulseStreamCapture::close() {
+    if (!ml_) return;
+
+    pa_threaded_mainloop_lock(ml_);
+    if (stream_) {
+        pa_stream_disconnect(stream_);
+        pa_stream_unref(stream_);
+        stream_ = nullptr;
+    }
+    if (ctx_) {
+        pa_context_disconnect(ctx_);
+        pa_context_unref(ctx_);
+        ctx_ = nullptr;
+    }
+    pa_threaded_mainloop_unlock(ml_);
+
+    pa_threaded_mainloop_stop(ml_);
+    pa_threaded_mainloop_free(ml_);
+    ml_ = nullptr;
+}
+
+CaptureStats PulseStreamCapture::stats() const {
+    CaptureStats s;
+    s.callbacks = callbacks_.load(std::memory_order_relaxed);
+    s.overruns_reported = true;
+    s.overruns = overruns_.load(std::memory_order_relaxed);
+    s.latency_ms = static_cast<double>(latency_us_.load(std::memory_order_relaxed)) / 1000.0;
+    return s;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "capture_backend.h"
+#include <atomic>
+#include <thread>
+
+struct pa_simple;
+struct pa_threaded_mainloop;
+struct pa_context;
+struct pa_stream;
+
+namespace PulseCapture {
+    // Native sample spec of `device` (or the default source). Only formats
+    // we can read directly are reported; anything else comes back as f32.
+    bool query_source_spec(const std::string& device, CaptureSpec& out);
+    void list_sources();
+}
+
+// Blocking pa_simple reads on a dedicated thread.
+class PulseSimpleCapture : public CaptureBackend {
+public:
+    ~PulseSimpleCapture() override;
+
+    bool open(const std::string& device, CaptureSpec& spec, int frame_ms, Callback on_frames) override;
+    void close() override;
+    const char* name() const override { return "pulse-simple"; }
+    CaptureStats stats() const override;
+
+private:
+    pa_simple* pa_ = nullptr;
+    CaptureSpec spec_;
+    size_t frame_ = 0;
+    Callback on_frames_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<uint64_t> callbacks_{0};
+    std::atomic<uint64_t> latency_us_{0};
+
+    void read_loop();
+};
+
+// Asynchronous pa_stream on a threaded mainloop, with fragsize set to the
+// requested frame length so the server wakes us every frame_ms.
+class PulseStreamCapture : public CaptureBackend {
+public:
+    ~PulseStreamCapture() override;
+
+    bool open(const std::string& device, CaptureSpec& spec, int frame_ms, Callback on_frames) override;
+    void close() override;
+    const char* name() const override { return "pulse-stream"; }
+    CaptureStats stats() const override;
+
+private:
+    pa_threaded_mainloop* ml_ = nullptr;
+    pa_context* ctx_ = nullptr;
+    pa_stream* stream_ = nullptr;
+    size_t frame_bytes_ = 0;
+    Callback on_frames_;
+    std::atomic<uint64_t> callbacks_{0};
+    std::atomic<uint64_t> overruns_{0};
+    std::atomic<uint64_t> latency_us_{0};
+
+    static void context_state_cb(pa_context* c, void* self);
+    static void stream_state_cb(pa_stream* s, void* self);
+    static void read_cb(pa_stream* s, size_t nbytes, void* self);
+    static void overflow_cb(pa_stream* s, void* self);
+};
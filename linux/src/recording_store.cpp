@@ -0,0 +1,113 @@
+#include "recording_store.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+
+RecordingStore::RecordingStore(size_t ram_limit_bytes) : ram_limit_(ram_limit_bytes) {}
+
+RecordingStore::~RecordingStore() {
+    if (fd_ >= 0) ::close(fd_);
+}
+
+void RecordingStore::append(const sample_t* data, size_t count) {
+    while (count > 0) {
+        size_t pos = size_ % BLOCK;
+        if (pos == 0) {
+            blocks_.emplace_back(new sample_t[BLOCK]);
+            spill();
+        }
+
+        size_t n = std::min(count, BLOCK - pos);
+        std::memcpy(blocks_.back().get() + pos, data, n * sizeof(sample_t));
+        data += n;
+        count -= n;
+        size_ += n;
+    }
+}
+
+size_t RecordingStore::read(size_t offset, size_t count, float* out) const {
+    if (offset >= size_) return 0;
+    count = std::min(count, size_ - offset);
+
+    size_t done = 0;
+    while (done < count) {
+        size_t block = (offset + done) / BLOCK;
+        size_t pos = (offset + done) % BLOCK;
+        size_t n = std::min(count - done, BLOCK - pos);
+
+        if (block >= spilled_) {
+            from_samples(blocks_[block].get() + pos, out + done, n);
+        } else {
+            scratch_.resize(BLOCK);
+            off_t at = static_cast<off_t>((block * BLOCK + pos) * sizeof(sample_t));
+            ssize_t got = pread(fd_, scratch_.data(), n * sizeof(sample_t), at);
+            if (got != static_cast<ssize_t>(n * sizeof(sample_t))) {
+                fprintf(stderr, "[RecordingStore] Spill read failed: %s\n", std::strerror(errno));
+                return done;
+            }
+            from_samples(scratch_.data(), out + done, n);
+        }
+        done += n;
+    }
+    return done;
+}
+
+std::vector<float> RecordingStore::read(size_t offset, size_t count) const {
+    std::vector<float> out(offset < size_ ? std::min(count, size_ - offset) : 0);
+    out.resize(read(offset, out.size(), out.data()));
+    return out;
+}
+
+void RecordingStore::clear() {
+    blocks_.clear();
+    spilled_ = 0;
+    size_ = 0;
+    if (fd_ >= 0 && ftruncate(fd_, 0) != 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+// Moves the oldest full blocks to disk until the resident set (including
+// the block being filled) fits the limit.
+void RecordingStore::spill() {
+    if (ram_limit_ == 0 || spill_failed_) return;
+
+    while (resident_bytes() > ram_limit_ && spilled_ + 1 < blocks_.size()) {
+        if (fd_ < 0 && !open_spill_file()) return;
+
+        off_t at = static_cast<off_t>(spilled_ * BLOCK * sizeof(sample_t));
+        const size_t bytes = BLOCK * sizeof(sample_t);
+        if (pwrite(fd_, blocks_[spilled_].get(), bytes, at) != static_cast<ssize_t>(bytes)) {
+            fprintf(stderr, "[RecordingStore] Spill write failed (%s), keeping recording in RAM\n",
+                    std::strerror(errno));
+            spill_failed_ = true;
+            return;
+        }
+        blocks_[spilled_].reset();
+        ++spilled_;
+    }
+}
+
+bool RecordingStore::open_spill_file() {
+    const char* dir = std::getenv("TMPDIR");
+    std::string path = std::string(dir && *dir ? dir : "/tmp") + "/speak-recording-XXXXXX";
+
+    fd_ = mkstemp(path.data());
+    if (fd_ < 0) {
+        fprintf(stderr, "[RecordingStore] Cannot create spill file in %s (%s), keeping recording in RAM\n",
+                dir && *dir ? dir : "/tmp", std::strerror(errno));
+        spill_failed_ = true;
+        return false;
+    }
+
+    // Nothing else needs the name; the file goes away with the descriptor.
+    unlink(path.c_str());
+    fprintf(stderr, "[RecordingStore] RAM limit of %zu MB reached, spilling to disk\n",
+            ram_limit_ >> 20);
+    return true;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "sample.h"
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Append-only store for one recording's 16 kHz samples (sample_t).
+//
+// Samples live in fixed-size blocks, so growing never reallocates or copies
+// what is already there. Once the resident blocks exceed the RAM limit the
+// oldest full blocks are written to an unlinked temporary file and freed;
+// read() pulls them back a slice at a time. A limit of 0 keeps everything
+// in memory.
+//
+// Not thread-safe; AudioEngine serialises access.
+class RecordingStore {
+public:
+    static constexpr size_t BLOCK = size_t(1) << 16;  // ~4 s at 16 kHz
+
+    explicit RecordingStore(size_t ram_limit_bytes = 0);
+    ~RecordingStore();
+
+    RecordingStore(const RecordingStore&) = delete;
+    RecordingStore& operator=(const RecordingStore&) = delete;
+
+    void append(const sample_t* data, size_t count);
+
+    // Copies up to `count` samples starting at `offset` into `out` as float
+    // and returns how many were copied.
+    size_t read(size_t offset, size_t count, float* out) const;
+    std::vector<float> read(size_t offset, size_t count) const;
+
+    void clear();
+
+    size_t size() const { return size_; }
+    size_t resident_bytes() const { return (blocks_.size() - spilled_) * BLOCK * sizeof(sample_t); }
+    size_t spilled_bytes() const { return spilled_ * BLOCK * sizeof(sample_t); }
+
+private:
+    size_t ram_limit_;
+    size_t size_ = 0;
+    std::vector<std::unique_ptr<sample_t[]>> blocks_;
+    size_t spilled_ = 0;  // blocks_[0, spilled_) are on disk and null here
+    int fd_ = -1;
+    bool spill_failed_ = false;
+    mutable std::vector<sample_t> scratch_;  // spilled samples on their way to float
+
+    void spill();
+    bool open_spill_file();
+};
@@ -0,0 +1,136 @@
+#include "resampler.h"
+#include "simd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+namespace {
+
+constexpr double PI = 3.14159265358979323846;
+constexpr int ZERO_CROSSINGS = 16;  // sinc half-width, in input samples at the cutoff
+constexpr double KAISER_BETA = 8.0;  // ~80 dB stopband
+constexpr double ROLLOFF = 0.94;     // cutoff as a fraction of the lower Nyquist
+
+double bessel_i0(double x) {
+    double sum = 1, term = 1, q = x * x / 4;
+    for (int k = 1; k < 64; ++k) {
+        term *= q / (static_cast<double>(k) * k);
+        sum += term;
+        if (term < sum * 1e-12) break;
+    }
+    return sum;
+}
+
+} // namespace
+
+void Resampler::configure(int from_rate, int to_rate) {
+    from_ = from_rate;
+    to_ = to_rate;
+    int g = std::gcd(from_rate, to_rate);
+    up_ = to_rate / g;
+    down_ = from_rate / g;
+
+    bank_.clear();
+    work_.clear();
+    taps_ = 0;
+    if (passthrough()) return;
+
+    double cutoff = ROLLOFF * 0.5 * std::min(from_rate, to_rate);
+    int taps = static_cast<int>(std::ceil(ZERO_CROSSINGS * from_rate / cutoff));
+    taps_ = (taps + 7) & ~7;
+
+    size_t n = static_cast<size_t>(taps_) * up_;
+    double wc = cutoff / (static_cast<double>(from_rate) * up_);
+    double center = static_cast<double>(n - 1) / 2.0;
+    double i0_beta = bessel_i0(KAISER_BETA);
+
+    std::vector<double> proto(n);
+    double sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+        double t = static_cast<double>(i) - center;
+        double x = 2.0 * wc * t;
+        double sinc = t == 0 ? 1.0 : std::sin(PI * x) / (PI * x);
+        double r = 2.0 * static_cast<double>(i) / static_cast<double>(n - 1) - 1.0;
+        double win = bessel_i0(KAISER_BETA * std::sqrt(std::max(0.0, 1.0 - r * r))) / i0_beta;
+        proto[i] = 2.0 * wc * sinc * win;
+        sum += proto[i];
+    }
+
+    // Unity DC gain per phase after zero-stuffing by up_.
+    double gain = static_cast<double>(up_) / sum;
+    bank_.resize(n);
+    for (int p = 0; p < up_; ++p) {
+        for (int k = 0; k < taps_; ++k) {
+            bank_[static_cast<size_t>(p) * taps_ + (taps_ - 1 - k)] =
+                static_cast<float>(proto[static_cast<size_t>(p) + static_cast<size_t>(k) * up_] * gain);
+        }
+    }
+
+    work_.assign(static_cast<size_t>(taps_ - 1) + BLOCK, 0.0f);
+    reset();
+}
+
+void Resampler::reset() {
+    if (passthrough()) return;
+    std::fill(work_.begin(), work_.begin() + (taps_ - 1), 0.0f);
+    next_ = static_cast<size_t>(taps_ - 1);
+    phase_ = 0;
+}
+
+size_t Resampler::run_block(size_t filled, float* out) {
+    const size_t hist = static_cast<size_t>(taps_ - 1);
+    const float* w = work_.data();
+    size_t produced = 0;
+
+    if (up_ == 1) {
+        const size_t step = static_cast<size_t>(down_);
+        for (; next_ < filled; next_ += step) {
+            out[produced++] = Simd::dot(bank_.data(), w + next_ - hist, taps_);
+        }
+    } else {
+        while (next_ < filled) {
+            const float* coeffs = bank_.data() + static_cast<size_t>(phase_) * taps_;
+            out[produced++] = Simd::dot(coeffs, w + next_ - hist, taps_);
+            phase_ += down_;
+            next_ += static_cast<size_t>(phase_ / up_);
+            phase_ %= up_;
+        }
+    }
+
+    std::memmove(work_.data(), work_.data() + filled - hist, hist * sizeof(float));
+    next_ -= filled - hist;
+    return produced;
+}
+
+size_t Resampler::process(const float* in, size_t count, float* out) {
+    if (passthrough()) {
+        std::memcpy(out, in, count * sizeof(float));
+        return count;
+    }
+
+    const size_t hist = static_cast<size_t>(taps_ - 1);
+    size_t produced = 0;
+    while (count > 0) {
+        size_t n = std::min(count, BLOCK);
+        std::memcpy(work_.data() + hist, in, n * sizeof(float));
+        produced += run_block(hist + n, out + produced);
+        in += n;
+        count -= n;
+    }
+    return produced;
+}
+
+void Resampler::process(const float* in, size_t count, std::vector<float>& out) {
+    size_t old = out.size();
+    out.resize(old + max_output(count));
+    size_t n = process(in, count, out.data() + old);
+    out.resize(old + n);
+}
+
+std::vector<float> Resampler::resample(const std::vector<float>& input) {
+    reset();
+    std::vector<float> out;
+    process(input.data(), input.size(), out);
+    return out;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Polyphase windowed-sinc sample-rate converter.
+//
+// The ratio is reduced to up/down (48000 -> 16000 is 1/3, 44100 -> 16000 is
+// 160/441) and a Kaiser-windowed low-pass is split into `up` phases, so each
+// output sample costs one `taps()`-long dot product. Integer decimation
+// (up == 1) skips the phase bookkeeping entirely.
+//
+// State is kept between process() calls, so the same instance can be fed a
+// live stream frame by frame or a whole buffer at once.
+class Resampler {
+public:
+    Resampler() = default;
+    Resampler(int from_rate, int to_rate) { configure(from_rate, to_rate); }
+
+    void configure(int from_rate, int to_rate);
+    void reset();
+
+    // Appends the output produced by `count` new input samples to `out`.
+    void process(const float* in, size_t count, std::vector<float>& out);
+
+    // Writes at most max_output(count) samples to `out`, returns how many.
+    size_t process(const float* in, size_t count, float* out);
+    size_t max_output(size_t count) const { return count * up_ / down_ + 1; }
+
+    std::vector<float> resample(const std::vector<float>& input);
+
+    bool passthrough() const { return up_ == down_; }
+    int from_rate() const { return from_; }
+    int to_rate() const { return to_; }
+    int up() const { return up_; }
+    int down() const { return down_; }
+    int taps() const { return taps_; }
+
+private:
+    static constexpr size_t BLOCK = 4096;
+
+    int from_ = 16000;
+    int to_ = 16000;
+    int up_ = 1;
+    int down_ = 1;
+    int taps_ = 0;
+    std::vector<float> bank_;  // up_ phases of taps_ coefficients, time-reversed
+    std::vector<float> work_;  // taps_ - 1 samples of history, then the current block
+    size_t next_ = 0;          // index in work_ of the newest input for the next output
+    int phase_ = 0;
+
+    size_t run_block(size_t filled, float* out);
+};
@@ -1,33 +1,124 @@
 #pragma once
 
+#include "sample.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
 #include <vector>
-#include <mutex>
 
+// Fixed-capacity single-producer/single-consumer ring of audio samples.
+//
+// The capture thread is the only producer: append() never blocks, never
+// allocates and never waits on the consumer. When the ring is full the
+// samples that do not fit are dropped and counted (drop-newest), so an
+// overrun shows up in dropped() instead of stalling the audio callback.
+//
+// Everything else (count, read_span, consume, drain, clear) belongs to the
+// consumer side and must not be called from more than one thread at a time.
 class RingBuffer {
-    std::vector<float> samples_;
-    mutable std::mutex mu_;
-
 public:
-    void append(const float* data, size_t count) {
-        std::lock_guard<std::mutex> lk(mu_);
-        samples_.insert(samples_.end(), data, data + count);
+    struct Span {
+        const sample_t* first = nullptr;
+        size_t first_len = 0;
+        const sample_t* second = nullptr;
+        size_t second_len = 0;
+
+        size_t size() const { return first_len + second_len; }
+        bool empty() const { return size() == 0; }
+    };
+
+    // Capacity is rounded up to a power of two. Storage is default-initialised
+    // so large rings are only committed as the producer first touches them.
+    explicit RingBuffer(size_t capacity) {
+        size_t cap = 1;
+        while (cap < capacity) cap <<= 1;
+        capacity_ = cap;
+        mask_ = cap - 1;
+        data_.reset(new sample_t[cap]);
     }
 
-    std::vector<float> drain() {
-        std::lock_guard<std::mutex> lk(mu_);
-        std::vector<float> out;
-        out.swap(samples_);
-        samples_.reserve(out.capacity());
-        return out;
+    RingBuffer(const RingBuffer&) = delete;
+    RingBuffer& operator=(const RingBuffer&) = delete;
+
+    size_t capacity() const { return capacity_; }
+
+    // Producer. Returns the number of samples written.
+    size_t append(const sample_t* data, size_t count) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t free = capacity_ - (head - cached_tail_);
+        if (free < count) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            free = capacity_ - (head - cached_tail_);
+        }
+
+        size_t n = count < free ? count : free;
+        if (n < count) dropped_.fetch_add(count - n, std::memory_order_relaxed);
+        if (n == 0) return 0;
+
+        size_t pos = head & mask_;
+        size_t first = n < capacity_ - pos ? n : capacity_ - pos;
+        std::memcpy(data_.get() + pos, data, first * sizeof(sample_t));
+        std::memcpy(data_.get(), data + first, (n - first) * sizeof(sample_t));
+
+        head_.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    // Consumer. Zero-copy view of everything readable right now; stays valid
+    // until the matching consume().
+    Span read_span() const {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t avail = head_.load(std::memory_order_acquire) - tail;
+
+        size_t pos = tail & mask_;
+        Span s;
+        s.first = data_.get() + pos;
+        s.first_len = avail < capacity_ - pos ? avail : capacity_ - pos;
+        s.second = data_.get();
+        s.second_len = avail - s.first_len;
+        return s;
+    }
+
+    void consume(size_t count) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t avail = head_.load(std::memory_order_acquire) - tail;
+        if (count > avail) count = avail;
+        tail_.store(tail + count, std::memory_order_release);
     }
 
-    double duration() const {
-        std::lock_guard<std::mutex> lk(mu_);
-        return static_cast<double>(samples_.size()) / 16000.0;
+    std::vector<sample_t> drain() {
+        Span s = read_span();
+        std::vector<sample_t> out;
+        out.reserve(s.size());
+        out.insert(out.end(), s.first, s.first + s.first_len);
+        out.insert(out.end(), s.second, s.second + s.second_len);
+        consume(s.size());
+        return out;
     }
 
+    void clear() { consume(read_span().size()); }
+
     size_t count() const {
-        std::lock_guard<std::mutex> lk(mu_);
-        return samples_.size();
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
     }
+
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    std::unique_ptr<sample_t[]> data_;
+    size_t capacity_ = 0;
+    size_t mask_ = 0;
+
+    // Producer-owned line: write index plus its cached copy of the read index.
+    alignas(CACHE_LINE) std::atomic<size_t> head_{0};
+    size_t cached_tail_ = 0;
+
+    // Consumer-owned line.
+    alignas(CACHE_LINE) std::atomic<size_t> tail_{0};
+
+    alignas(CACHE_LINE) std::atomic<uint64_t> dropped_{0};
 };
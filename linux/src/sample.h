@@ -0,0 +1,31 @@
+#pragma once
+
+#include "simd.h"
+#include <cstdint>
+#include <cstring>
+
+// Type of buffered audio: the capture ring and the recording store.
+// Building with SPEAK_S16_SAMPLES keeps it as 16-bit PCM, which halves the
+// memory and bandwidth of long recordings; samples are only widened to
+// float on their way out to whisper.
+#ifdef SPEAK_S16_SAMPLES
+using sample_t = int16_t;
+#else
+using sample_t = float;
+#endif
+
+inline void to_samples(const float* in, sample_t* out, size_t n) {
+#ifdef SPEAK_S16_SAMPLES
+    Simd::float_to_s16(in, out, n);
+#else
+    std::memcpy(out, in, n * sizeof(float));
+#endif
+}
+
+inline void from_samples(const sample_t* in, float* out, size_t n) {
+#ifdef SPEAK_S16_SAMPLES
+    Simd::s16_to_float(in, out, n);
+#else
+    std::memcpy(out, in, n * sizeof(float));
+#endif
+}
@@ -13,6 +13,33 @@ static std::string config_dir() {
     return std::string(home ? home : ".") + "/.config/speak";
 }
 
+const char* audio_backend_name(AudioBackend b) {
+    switch (b) {
+    case AudioBackend::pulse_simple: return "pulse-simple";
+    case AudioBackend::pipewire: return "pipewire";
+    case AudioBackend::pulse_stream: break;
+    }
+    return "pulse-stream";
+}
+
+const char* vad_backend_name(VadBackend b) {
+    switch (b) {
+    case VadBackend::spectral: return "spectral";
+    case VadBackend::silero: return "silero";
+    case VadBackend::energy: break;
+    }
+    return "energy";
+}
+
+const char* transcription_mode_name(TranscriptionMode m) {
+    switch (m) {
+    case TranscriptionMode::buffered: return "buffered";
+    case TranscriptionMode::streaming: return "streaming";
+    case TranscriptionMode::continuous: break;
+    }
+    return "continuous";
+}
+
 std::string Settings::config_path() {
     return config_dir() + "/settings.json";
 }
@@ -45,6 +72,14 @@ Settings Settings::load() {
     get("thread_count", s.thread_count);
     get("use_gpu", s.use_gpu);
     get("flash_attention", s.flash_attention);
+    get("whisper_states", s.whisper_states);
+    get("incremental_mel", s.incremental_mel);
+    get("dynamic_audio_ctx", s.dynamic_audio_ctx);
+    get("audio_ctx_margin_ms", s.audio_ctx_margin_ms);
+    get("audio_ctx_min", s.audio_ctx_min);
+    get("model_cache_mb", s.model_cache_mb);
+    get("long_model", s.long_model);
+    get("long_model_after_ms", s.long_model_after_ms);
     get("no_context", s.no_context);
     get("single_segment", s.single_segment);
     get("no_timestamps", s.no_timestamps);
@@ -62,6 +97,19 @@ Settings Settings::load() {
     get("vad_min_silence_ms", s.vad_min_silence_ms);
     get("vad_pre_padding_ms", s.vad_pre_padding_ms);
     get("vad_post_padding_ms", s.vad_post_padding_ms);
+    get("vad_adaptive", s.vad_adaptive);
+    get("vad_speech_ratio", s.vad_speech_ratio);
+    get("vad_silence_ratio", s.vad_silence_ratio);
+    get("vad_speech_score", s.vad_speech_score);
+    get("vad_silence_score", s.vad_silence_score);
+    get("vad_speech_probability", s.vad_speech_probability);
+    get("vad_silence_probability", s.vad_silence_probability);
+    get("vad_prefilter", s.vad_prefilter);
+
+    std::string vad_backend;
+    get("vad_backend", vad_backend);
+    if (vad_backend == "spectral") s.vad_backend = VadBackend::spectral;
+    else if (vad_backend == "silero") s.vad_backend = VadBackend::silero;
 
     std::string mode;
     get("output_mode", mode);
@@ -73,10 +121,27 @@ Settings Settings::load() {
     get("hotkey_keysym", s.hotkey_keysym);
     get("send_hotkey_keysym", s.send_hotkey_keysym);
     get("keep_mic_warm", s.keep_mic_warm);
+    get("pre_roll_ms", s.pre_roll_ms);
+    get("recording_ram_limit_mb", s.recording_ram_limit_mb);
+
+    std::string cfmt;
+    get("capture_format", cfmt);
+    if (cfmt == "float48k") s.capture_format = CaptureFormat::float48k;
+
+    std::string backend;
+    get("audio_backend", backend);
+    if (backend == "pulse-simple") s.audio_backend = AudioBackend::pulse_simple;
+    else if (backend == "pipewire") s.audio_backend = AudioBackend::pipewire;
+    get("capture_frame_ms", s.capture_frame_ms);
+    get("capture_realtime", s.capture_realtime);
+    get("capture_rt_priority", s.capture_rt_priority);
+    get("capture_cpu", s.capture_cpu);
 
     std::string tmode;
     get("transcription_mode", tmode);
     if (tmode == "buffered") s.transcription_mode = TranscriptionMode::buffered;
+    else if (tmode == "streaming") s.transcription_mode = TranscriptionMode::streaming;
+    get("stream_step_ms", s.stream_step_ms);
 
     get("release_delay_ms", s.release_delay_ms);
     get("launch_at_login", s.launch_at_login);
@@ -97,6 +162,14 @@ void Settings::save() const {
     j["thread_count"] = thread_count;
     j["use_gpu"] = use_gpu;
     j["flash_attention"] = flash_attention;
+    j["whisper_states"] = whisper_states;
+    j["incremental_mel"] = incremental_mel;
+    j["dynamic_audio_ctx"] = dynamic_audio_ctx;
+    j["audio_ctx_margin_ms"] = audio_ctx_margin_ms;
+    j["audio_ctx_min"] = audio_ctx_min;
+    j["model_cache_mb"] = model_cache_mb;
+    j["long_model"] = long_model;
+    j["long_model_after_ms"] = long_model_after_ms;
     j["no_context"] = no_context;
     j["single_segment"] = single_segment;
     j["no_timestamps"] = no_timestamps;
@@ -114,6 +187,15 @@ void Settings::save() const {
     j["vad_min_silence_ms"] = vad_min_silence_ms;
     j["vad_pre_padding_ms"] = vad_pre_padding_ms;
     j["vad_post_padding_ms"] = vad_post_padding_ms;
+    j["vad_adaptive"] = vad_adaptive;
+    j["vad_speech_ratio"] = vad_speech_ratio;
+    j["vad_silence_ratio"] = vad_silence_ratio;
+    j["vad_backend"] = vad_backend_name(vad_backend);
+    j["vad_speech_score"] = vad_speech_score;
+    j["vad_silence_score"] = vad_silence_score;
+    j["vad_speech_probability"] = vad_speech_probability;
+    j["vad_silence_probability"] = vad_silence_probability;
+    j["vad_prefilter"] = vad_prefilter;
     j["output_mode"] = (output_mode == OutputMode::type) ? "type" : "paste";
     j["type_speed_ms"] = type_speed_ms;
     j["restore_clipboard"] = restore_clipboard;
@@ -121,7 +203,16 @@ void Settings::save() const {
     j["hotkey_keysym"] = hotkey_keysym;
     j["send_hotkey_keysym"] = send_hotkey_keysym;
     j["keep_mic_warm"] = keep_mic_warm;
-    j["transcription_mode"] = (transcription_mode == TranscriptionMode::buffered) ? "buffered" : "continuous";
+    j["pre_roll_ms"] = pre_roll_ms;
+    j["recording_ram_limit_mb"] = recording_ram_limit_mb;
+    j["capture_format"] = (capture_format == CaptureFormat::float48k) ? "float48k" : "native";
+    j["audio_backend"] = audio_backend_name(audio_backend);
+    j["capture_frame_ms"] = capture_frame_ms;
+    j["capture_realtime"] = capture_realtime;
+    j["capture_rt_priority"] = capture_rt_priority;
+    j["capture_cpu"] = capture_cpu;
+    j["transcription_mode"] = transcription_mode_name(transcription_mode);
+    j["stream_step_ms"] = stream_step_ms;
     j["release_delay_ms"] = release_delay_ms;
     j["launch_at_login"] = launch_at_login;
 
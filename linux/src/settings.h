@@ -6,7 +6,14 @@
 
 enum class SamplingStrategy { greedy, beam_search };
 enum class OutputMode { type, paste };
-enum class TranscriptionMode { buffered, continuous };
+enum class TranscriptionMode { buffered, continuous, streaming };
+enum class CaptureFormat { native, float48k };
+enum class AudioBackend { pulse_stream, pulse_simple, pipewire };
+enum class VadBackend { energy, spectral, silero };
+
+const char* audio_backend_name(AudioBackend b);
+const char* vad_backend_name(VadBackend b);
+const char* transcription_mode_name(TranscriptionMode m);
 
 struct Settings {
     SamplingStrategy strategy = SamplingStrategy::greedy;
@@ -20,6 +27,35 @@ struct Settings {
     int thread_count = 0;
     bool use_gpu = true;
     bool flash_attention = true;
+    // Decoding states sharing one copy of the model weights; this many
+    // transcriptions, or chunks of one long recording, can run at once.
+    // Each extra state carries its own KV cache and compute buffers
+    // (hundreds of MB on larger models), created on first use and not
+    // counted against model_cache_mb, so parallel decoding is opt-in.
+    int whisper_states = 1;
+    // Buffered mode: compute the log-mel spectrogram while recording, so
+    // release goes straight to encoding. Opt-in: it follows whisper.cpp's
+    // own mel pass with the model's filterbank, but is a separate
+    // implementation (a DFT in float rather than whisper's FFT), so its
+    // output matches to rounding rather than bit for bit.
+    bool incremental_mel = false;
+    // Size the encoder window (audio_ctx) to the utterance instead of the
+    // full 30 s: the audio length plus a margin, never below a minimum, in
+    // encoder frames of 20 ms. Opt-in, since stock models can lose words
+    // with a short context; models fine-tuned for it get a lower floor.
+    bool dynamic_audio_ctx = false;
+    int audio_ctx_margin_ms = 1000;
+    int audio_ctx_min = 256;
+    // Models kept loaded at once, within this much RAM (0: only the one in
+    // use). A model is charged the RSS its load and warmup added, at least
+    // its file size; that is approximate, since other threads allocate
+    // meanwhile, and whisper states created later are not counted.
+    // Buffered recordings of at least long_model_after_ms go to long_model
+    // (an id or display name) when it is loaded, so a small model can serve
+    // short commands and a large one dictation without reloads.
+    int model_cache_mb = 0;
+    std::string long_model;
+    int long_model_after_ms = 10000;
 
     bool no_context = true;
     bool single_segment = false;
@@ -40,6 +76,19 @@ struct Settings {
     int vad_min_silence_ms = 600;
     int vad_pre_padding_ms = 200;
     int vad_post_padding_ms = 300;
+    VadBackend vad_backend = VadBackend::energy;
+    // Off by default so vad_speech_threshold and vad_silence_threshold mean
+    // what they always have; see VoiceActivityDetector::adaptive.
+    bool vad_adaptive = false;
+    float vad_speech_ratio = 3.0f;
+    float vad_silence_ratio = 1.8f;
+    float vad_speech_score = 0.6f;
+    float vad_silence_score = 0.4f;
+    float vad_speech_probability = 0.5f;
+    float vad_silence_probability = 0.35f;
+    // Buffered recordings longer than one chunk get a Silero pass before
+    // decoding, and only the speech it finds is sent to whisper.
+    bool vad_prefilter = false;
 
     OutputMode output_mode = OutputMode::type;
     int type_speed_ms = 5;
@@ -49,8 +98,18 @@ struct Settings {
     uint32_t hotkey_keysym = 0xFFC9;      // XK_F12
     uint32_t send_hotkey_keysym = 0xFFC8;  // XK_F11
     bool keep_mic_warm = true;
+    int pre_roll_ms = 400;
+    int recording_ram_limit_mb = 64;
+    CaptureFormat capture_format = CaptureFormat::native;
+    AudioBackend audio_backend = AudioBackend::pulse_stream;
+    int capture_frame_ms = 20;
+    bool capture_realtime = true;
+    int capture_rt_priority = 10;
+    int capture_cpu = -1;
 
     TranscriptionMode transcription_mode = TranscriptionMode::continuous;
+    // Streaming mode re-decodes the current utterance this often.
+    int stream_step_ms = 500;
     int release_delay_ms = 300;
 
     bool launch_at_login = false;
@@ -0,0 +1,208 @@
+#include "silero_vad.h"
+#include "whisper.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+static constexpr size_t INPUT_CHUNK = 4096;
+
+// Set on the thread while it is inside whisper_vad_detect_speech().
+static thread_local bool t_scoring = false;
+
+// whisper_vad_detect_speech() logs at info level on every call, which for a
+// live stream is every 32 ms. Those lines are dropped while scoring; every
+// other line, including all of the transcription context's, goes to stderr
+// as with whisper's default logger. The logger is process-wide, so it is
+// installed once and filters by thread rather than swapped in and out.
+static void filter_vad_log(ggml_log_level level, const char* text, void*) {
+    if (t_scoring && level <= GGML_LOG_LEVEL_INFO && std::strncmp(text, "whisper_vad_", 12) == 0) return;
+    fputs(text, stderr);
+}
+
+SileroVad::~SileroVad() {
+    if (scorer_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lk(wake_mu_);
+            running_ = false;
+        }
+        wake_cv_.notify_all();
+        scorer_.join();
+    }
+    if (ctx_) whisper_vad_free(ctx_);
+}
+
+bool SileroVad::load(const std::string& model_path) {
+    if (ctx_) return true;
+
+    auto cparams = whisper_vad_default_context_params();
+    cparams.n_threads = 1;
+    cparams.use_gpu = false;
+
+    ctx_ = whisper_vad_init_from_file_with_params(model_path.c_str(), cparams);
+    if (!ctx_) {
+        fprintf(stderr, "[SileroVad] Failed to load %s\n", model_path.c_str());
+        return false;
+    }
+
+    static std::once_flag log_once;
+    std::call_once(log_once, [] { whisper_log_set(filter_vad_log, nullptr); });
+
+    history_.resize(WINDOW * CONTEXT_WINDOWS);
+    scratch_.assign(WINDOW * (CONTEXT_WINDOWS + QUEUE_WINDOWS), 0.0f);
+    window_.assign(WINDOW, 0.0f);
+    if (background) {
+        queue_.assign(WINDOW * QUEUE_WINDOWS, 0.0f);
+        queue_epochs_.assign(QUEUE_WINDOWS, 0);
+        running_ = true;
+        scorer_ = std::thread(&SileroVad::scorer_loop, this);
+    }
+    fprintf(stderr, "[SileroVad] Loaded %s (%s)\n", model_path.c_str(), background ? "scoring thread" : "inline");
+    return true;
+}
+
+void SileroVad::reset(int sample_rate) {
+    if (sample_rate > 0 && sample_rate != sample_rate_) {
+        sample_rate_ = sample_rate;
+        decimator_.configure(sample_rate, 16000);
+        resampled_.assign(decimator_.max_output(INPUT_CHUNK), 0.0f);
+    }
+    decimator_.reset();
+    window_fill_ = 0;
+    if (background) {
+        epoch_.fetch_add(1, std::memory_order_release);
+    } else {
+        history_.clear();
+    }
+    probability_.store(0, std::memory_order_relaxed);
+}
+
+float SileroVad::process(const float* samples, size_t count) {
+    if (!ctx_ || sample_rate_ == 0) return 0;
+
+    for (size_t off = 0; off < count; off += INPUT_CHUNK) {
+        size_t n = std::min(INPUT_CHUNK, count - off);
+        const float* in = samples + off;
+        if (!decimator_.passthrough()) {
+            n = decimator_.process(in, n, resampled_.data());
+            in = resampled_.data();
+        }
+
+        while (n > 0) {
+            size_t take = std::min(n, WINDOW - window_fill_);
+            std::memcpy(window_.data() + window_fill_, in, take * sizeof(float));
+            window_fill_ += take;
+            in += take;
+            n -= take;
+            if (window_fill_ == WINDOW) {
+                submit_window();
+                window_fill_ = 0;
+            }
+        }
+    }
+    return probability();
+}
+
+void SileroVad::submit_window() {
+    if (!background) {
+        std::copy(window_.begin(), window_.end(), scratch_.begin() + static_cast<std::ptrdiff_t>(WINDOW * CONTEXT_WINDOWS));
+        probability_.store(score(1), std::memory_order_relaxed);
+        return;
+    }
+
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) >= QUEUE_WINDOWS) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    size_t slot = head % QUEUE_WINDOWS;
+    std::copy(window_.begin(), window_.end(), queue_.begin() + static_cast<std::ptrdiff_t>(slot * WINDOW));
+    queue_epochs_[slot] = epoch_.load(std::memory_order_relaxed);
+    head_.store(head + 1, std::memory_order_release);
+    // Not under wake_mu_, so a wakeup can be missed; the scorer's timeout
+    // of one window bounds the delay.
+    wake_cv_.notify_one();
+}
+
+void SileroVad::scorer_loop() {
+    uint64_t epoch = 0;
+    const auto timeout = std::chrono::milliseconds(WINDOW * 1000 / 16000);
+
+    std::unique_lock<std::mutex> lk(wake_mu_);
+    while (running_) {
+        wake_cv_.wait_for(lk, timeout, [this] {
+            return !running_ || head_.load(std::memory_order_acquire) != tail_.load(std::memory_order_relaxed);
+        });
+        if (!running_) break;
+        lk.unlock();
+
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t head = head_.load(std::memory_order_acquire);
+        uint64_t current = epoch_.load(std::memory_order_acquire);
+        if (current != epoch) {
+            epoch = current;
+            history_.clear();
+        }
+
+        size_t count = 0;
+        float* pending = scratch_.data() + WINDOW * CONTEXT_WINDOWS;
+        for (; tail != head; ++tail) {
+            size_t slot = tail % QUEUE_WINDOWS;
+            uint64_t e = queue_epochs_[slot];
+            if (e < epoch) continue;  // cut before a reset
+            if (e > epoch) break;     // after one; taken next round
+            std::copy(queue_.begin() + static_cast<std::ptrdiff_t>(slot * WINDOW),
+                      queue_.begin() + static_cast<std::ptrdiff_t>((slot + 1) * WINDOW),
+                      pending + count * WINDOW);
+            ++count;
+        }
+        tail_.store(tail, std::memory_order_release);
+
+        if (count > 0) {
+            float p = score(count);
+            if (epoch_.load(std::memory_order_acquire) == epoch) probability_.store(p, std::memory_order_relaxed);
+        }
+        lk.lock();
+    }
+}
+
+float SileroVad::score(size_t count) {
+    // Put the history right in front of the new windows.
+    auto h = history_.spans();
+    size_t start = WINDOW * CONTEXT_WINDOWS - h.size();
+    std::copy(h.first, h.first + h.first_len, scratch_.begin() + static_cast<std::ptrdiff_t>(start));
+    std::copy(h.second, h.second + h.second_len,
+              scratch_.begin() + static_cast<std::ptrdiff_t>(start + h.first_len));
+
+    const float* audio = scratch_.data() + start;
+    size_t n = h.size() + count * WINDOW;
+
+    auto t0 = std::chrono::steady_clock::now();
+    t_scoring = true;
+    bool ok = whisper_vad_detect_speech(ctx_, audio, static_cast<int>(n));
+    t_scoring = false;
+    uint64_t ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - t0).count()) / count;
+
+    history_.push(scratch_.data() + WINDOW * CONTEXT_WINDOWS, count * WINDOW);
+
+    windows_.fetch_add(count, std::memory_order_relaxed);
+    total_ns_.fetch_add(ns * count, std::memory_order_relaxed);
+    if (ns > max_ns_.load(std::memory_order_relaxed)) max_ns_.store(ns, std::memory_order_relaxed);
+
+    int n_probs = ok ? whisper_vad_n_probs(ctx_) : 0;
+    return n_probs > 0 ? whisper_vad_probs(ctx_)[n_probs - 1] : probability();
+}
+
+SileroStats SileroVad::stats() const {
+    SileroStats s;
+    s.probability = probability();
+    s.windows = windows_.load(std::memory_order_relaxed);
+    s.dropped = dropped_.load(std::memory_order_relaxed);
+    if (s.windows > 0) {
+        s.mean_us = static_cast<double>(total_ns_.load(std::memory_order_relaxed)) / 1000.0 / static_cast<double>(s.windows);
+    }
+    s.max_us = static_cast<double>(max_ns_.load(std::memory_order_relaxed)) / 1000.0;
+    s.budget_us = static_cast<double>(WINDOW) * 1e6 / 16000.0;
+    return s;
+}
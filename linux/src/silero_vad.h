@@ -0,0 +1,107 @@
+#pragma once
+
+#include "circular_buffer.h"
+#include "resampler.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct whisper_vad_context;
+
+struct SileroStats {
+    float probability = 0;
+    uint64_t windows = 0;
+    uint64_t dropped = 0; // windows the scorer fell too far behind to take
+    double mean_us = 0;   // per window
+    double max_us = 0;
+    double budget_us = 0; // audio duration of one window
+};
+
+// Silero speech probability for a live stream, through whisper.cpp's VAD
+// context. The audio engine feeds it 16 kHz, where the decimator is a
+// passthrough; other rates are brought to 16 kHz internally. Scored in
+// 512-sample (32 ms) windows.
+//
+// whisper_vad_detect_speech() clears the LSTM state on every call, so each
+// new window is scored together with the CONTEXT_WINDOWS before it to give
+// the network some history; the probability reported is the last window's.
+//
+// With `background` set (the default), process() only cuts windows and
+// hands them to a scoring thread through a fixed queue, so the capture
+// thread neither runs the network nor allocates; the probability it reads
+// is then the latest one scored, a window behind at most. A scorer that
+// falls behind takes every pending window in one call, sharing the context.
+// Offline callers (evaluation, benchmarks) clear `background` before load()
+// and get each window scored inline.
+class SileroVad {
+public:
+    static constexpr size_t WINDOW = 512;
+    static constexpr size_t CONTEXT_WINDOWS = 3;
+    static constexpr size_t QUEUE_WINDOWS = 32;
+
+    bool background = true;
+
+    SileroVad() = default;
+    ~SileroVad();
+
+    SileroVad(const SileroVad&) = delete;
+    SileroVad& operator=(const SileroVad&) = delete;
+
+    bool load(const std::string& model_path);
+    bool loaded() const { return ctx_ != nullptr; }
+
+    // Sets the input rate and clears all stream state. Called from the
+    // thread that calls process().
+    void reset(int sample_rate);
+    int sample_rate() const { return sample_rate_; }
+
+    // Feeds samples at the rate given to reset() and returns the most recent
+    // speech probability (unchanged if no window completed).
+    float process(const float* samples, size_t count);
+
+    float probability() const { return probability_.load(std::memory_order_relaxed); }
+    SileroStats stats() const;
+
+private:
+    whisper_vad_context* ctx_ = nullptr;
+
+    // Producer side: the thread calling process().
+    Resampler decimator_;
+    int sample_rate_ = 0;
+    std::vector<float> resampled_;
+    std::vector<float> window_;
+    size_t window_fill_ = 0;
+
+    // Windows waiting for the scorer, each tagged with the epoch (reset()
+    // count) it was cut in, so windows from before a reset are skipped.
+    std::vector<float> queue_;
+    std::vector<uint64_t> queue_epochs_;
+    std::atomic<size_t> head_{0};
+    std::atomic<size_t> tail_{0};
+    std::atomic<uint64_t> epoch_{0};
+
+    std::thread scorer_;
+    std::atomic<bool> running_{false};
+    std::mutex wake_mu_;
+    std::condition_variable wake_cv_;
+
+    // Scorer side (the producer's when scoring inline).
+    CircularBuffer<float> history_;
+    std::vector<float> scratch_;
+
+    std::atomic<float> probability_{0};
+    std::atomic<uint64_t> windows_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> total_ns_{0};
+    std::atomic<uint64_t> max_ns_{0};
+
+    void submit_window();
+    void scorer_loop();
+    // Scores `count` windows laid out at `scratch_ + CONTEXT_WINDOWS * WINDOW`
+    // after the history, then adds them to the history.
+    float score(size_t count);
+};
@@ -0,0 +1,352 @@
+#include "simd.h"
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SPEAK_SIMD_X86 1
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+#define SPEAK_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+constexpr float S16_SCALE = 32768.0f;
+
+inline int16_t s16_from_float(float x) {
+    float v = x * S16_SCALE;
+    if (v >= 32767.0f) return 32767;
+    if (v <= -32768.0f) return -32768;
+    return static_cast<int16_t>(std::lrintf(v));
+}
+
+#if SPEAK_SIMD_X86
+
+__attribute__((target("avx2,fma")))
+float dot_avx2(const float* a, const float* b, size_t n) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), acc1);
+    }
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+    }
+    __m256 acc = _mm256_add_ps(acc0, acc1);
+    __m128 lo = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    lo = _mm_add_ps(lo, _mm_movehl_ps(lo, lo));
+    lo = _mm_add_ss(lo, _mm_shuffle_ps(lo, lo, 1));
+    float sum = _mm_cvtss_f32(lo);
+    for (; i < n; ++i) sum += a[i] * b[i];
+    return sum;
+}
+
+__attribute__((target("avx2,fma")))
+void multiply_avx2(const float* a, const float* b, float* out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+    }
+    for (; i < n; ++i) out[i] = a[i] * b[i];
+}
+
+__attribute__((target("avx2,fma")))
+void power_avx2(const float* re, const float* im, float* out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 r = _mm256_loadu_ps(re + i);
+        __m256 m = _mm256_loadu_ps(im + i);
+        _mm256_storeu_ps(out + i, _mm256_fmadd_ps(r, r, _mm256_mul_ps(m, m)));
+    }
+    for (; i < n; ++i) out[i] = re[i] * re[i] + im[i] * im[i];
+}
+
+// Counts lanes where x[i] and x[i+1] differ in sign bit.
+__attribute__((target("avx2")))
+size_t zero_crossings_avx2(const float* x, size_t n) {
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 9 <= n; i += 8) {
+        __m256 a = _mm256_loadu_ps(x + i);
+        __m256 b = _mm256_loadu_ps(x + i + 1);
+        int mask = _mm256_movemask_ps(_mm256_xor_ps(a, b));
+        count += static_cast<size_t>(__builtin_popcount(static_cast<unsigned>(mask)));
+    }
+    for (; i + 1 < n; ++i) count += std::signbit(x[i]) != std::signbit(x[i + 1]);
+    return count;
+}
+
+__attribute__((target("avx2")))
+void s16_to_float_avx2(const int16_t* in, float* out, size_t n) {
+    const __m256 scale = _mm256_set1_ps(1.0f / S16_SCALE);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)));
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), scale));
+    }
+    for (; i < n; ++i) out[i] = static_cast<float>(in[i]) / S16_SCALE;
+}
+
+__attribute__((target("avx2")))
+void float_to_s16_avx2(const float* in, int16_t* out, size_t n) {
+    const __m256 scale = _mm256_set1_ps(S16_SCALE);
+    const __m256 hi = _mm256_set1_ps(32767.0f);
+    const __m256 lo = _mm256_set1_ps(-32768.0f);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256 a = _mm256_max_ps(_mm256_min_ps(_mm256_mul_ps(_mm256_loadu_ps(in + i), scale), hi), lo);
+        __m256 b = _mm256_max_ps(_mm256_min_ps(_mm256_mul_ps(_mm256_loadu_ps(in + i + 8), scale), hi), lo);
+        // packs works per 128-bit lane; put the quadwords back in order.
+        __m256i packed = _mm256_packs_epi32(_mm256_cvtps_epi32(a), _mm256_cvtps_epi32(b));
+        packed = _mm256_permute4x64_epi64(packed, 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), packed);
+    }
+    for (; i < n; ++i) out[i] = s16_from_float(in[i]);
+}
+
+__attribute__((target("sse2")))
+void multiply_sse(const float* a, const float* b, float* out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+    for (; i < n; ++i) out[i] = a[i] * b[i];
+}
+
+__attribute__((target("sse2")))
+void power_sse(const float* re, const float* im, float* out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 r = _mm_loadu_ps(re + i);
+        __m128 m = _mm_loadu_ps(im + i);
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_mul_ps(r, r), _mm_mul_ps(m, m)));
+    }
+    for (; i < n; ++i) out[i] = re[i] * re[i] + im[i] * im[i];
+}
+
+__attribute__((target("sse2")))
+size_t zero_crossings_sse(const float* x, size_t n) {
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 5 <= n; i += 4) {
+        __m128 a = _mm_loadu_ps(x + i);
+        __m128 b = _mm_loadu_ps(x + i + 1);
+        int mask = _mm_movemask_ps(_mm_xor_ps(a, b));
+        count += static_cast<size_t>(__builtin_popcount(static_cast<unsigned>(mask)));
+    }
+    for (; i + 1 < n; ++i) count += std::signbit(x[i]) != std::signbit(x[i + 1]);
+    return count;
+}
+
+__attribute__((target("sse2")))
+void s16_to_float_sse(const int16_t* in, float* out, size_t n) {
+    const __m128 scale = _mm_set1_ps(1.0f / S16_SCALE);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        // Sign-extend by placing each sample in the high half and shifting down.
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+    for (; i < n; ++i) out[i] = static_cast<float>(in[i]) / S16_SCALE;
+}
+
+__attribute__((target("sse2")))
+void float_to_s16_sse(const float* in, int16_t* out, size_t n) {
+    const __m128 scale = _mm_set1_ps(S16_SCALE);
+    const __m128 hi = _mm_set1_ps(32767.0f);
+    const __m128 lo = _mm_set1_ps(-32768.0f);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128 a = _mm_max_ps(_mm_min_ps(_mm_mul_ps(_mm_loadu_ps(in + i), scale), hi), lo);
+        __m128 b = _mm_max_ps(_mm_min_ps(_mm_mul_ps(_mm_loadu_ps(in + i + 4), scale), hi), lo);
+        __m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), packed);
+    }
+    for (; i < n; ++i) out[i] = s16_from_float(in[i]);
+}
+
+__attribute__((target("sse2")))
+float dot_sse(const float* a, const float* b, size_t n) {
+    __m128 acc = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+    acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+    acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+    float sum = _mm_cvtss_f32(acc);
+    for (; i < n; ++i) sum += a[i] * b[i];
+    return sum;
+}
+
+bool has_avx2() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+
+const bool g_avx2 = has_avx2();
+
+#elif SPEAK_SIMD_NEON
+
+float dot_neon(const float* a, const float* b, size_t n) {
+    float32x4_t acc0 = vdupq_n_f32(0);
+    float32x4_t acc1 = vdupq_n_f32(0);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = vmlaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc1 = vmlaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    acc0 = vaddq_f32(acc0, acc1);
+    float32x2_t s = vadd_f32(vget_low_f32(acc0), vget_high_f32(acc0));
+    float sum = vget_lane_f32(vpadd_f32(s, s), 0);
+    for (; i < n; ++i) sum += a[i] * b[i];
+    return sum;
+}
+
+void multiply_neon(const float* a, const float* b, float* out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) vst1q_f32(out + i, vmulq_f32(vld1q_f32(a + i), vld1q_f32(b + i)));
+    for (; i < n; ++i) out[i] = a[i] * b[i];
+}
+
+void power_neon(const float* re, const float* im, float* out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t r = vld1q_f32(re + i);
+        float32x4_t m = vld1q_f32(im + i);
+        vst1q_f32(out + i, vmlaq_f32(vmulq_f32(m, m), r, r));
+    }
+    for (; i < n; ++i) out[i] = re[i] * re[i] + im[i] * im[i];
+}
+
+size_t zero_crossings_neon(const float* x, size_t n) {
+    uint32x4_t acc = vdupq_n_u32(0);
+    size_t i = 0;
+    for (; i + 5 <= n; i += 4) {
+        uint32x4_t a = vreinterpretq_u32_f32(vld1q_f32(x + i));
+        uint32x4_t b = vreinterpretq_u32_f32(vld1q_f32(x + i + 1));
+        acc = vaddq_u32(acc, vshrq_n_u32(veorq_u32(a, b), 31));
+    }
+    uint32x2_t s = vadd_u32(vget_low_u32(acc), vget_high_u32(acc));
+    size_t count = vget_lane_u32(vpadd_u32(s, s), 0);
+    for (; i + 1 < n; ++i) count += std::signbit(x[i]) != std::signbit(x[i + 1]);
+    return count;
+}
+
+void s16_to_float_neon(const int16_t* in, float* out, size_t n) {
+    const float32x4_t scale = vdupq_n_f32(1.0f / S16_SCALE);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        int16x8_t v = vld1q_s16(in + i);
+        vst1q_f32(out + i, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), scale));
+        vst1q_f32(out + i + 4, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), scale));
+    }
+    for (; i < n; ++i) out[i] = static_cast<float>(in[i]) / S16_SCALE;
+}
+
+void float_to_s16_neon(const float* in, int16_t* out, size_t n) {
+    size_t i = 0;
+#if defined(__aarch64__)
+    const float32x4_t scale = vdupq_n_f32(S16_SCALE);
+    for (; i + 8 <= n; i += 8) {
+        // vcvtnq rounds to nearest; vqmovn saturates to 16 bits.
+        int32x4_t a = vcvtnq_s32_f32(vmulq_f32(vld1q_f32(in + i), scale));
+        int32x4_t b = vcvtnq_s32_f32(vmulq_f32(vld1q_f32(in + i + 4), scale));
+        vst1q_s16(out + i, vcombine_s16(vqmovn_s32(a), vqmovn_s32(b)));
+    }
+#endif
+    for (; i < n; ++i) out[i] = s16_from_float(in[i]);
+}
+
+#else
+
+float dot_scalar(const float* a, const float* b, size_t n) {
+    float sum = 0;
+    for (size_t i = 0; i < n; ++i) sum += a[i] * b[i];
+    return sum;
+}
+
+#endif
+
+} // namespace
+
+float Simd::dot(const float* a, const float* b, size_t n) {
+#if SPEAK_SIMD_X86
+    return g_avx2 ? dot_avx2(a, b, n) : dot_sse(a, b, n);
+#elif SPEAK_SIMD_NEON
+    return dot_neon(a, b, n);
+#else
+    return dot_scalar(a, b, n);
+#endif
+}
+
+void Simd::multiply(const float* a, const float* b, float* out, size_t n) {
+#if SPEAK_SIMD_X86
+    if (g_avx2) multiply_avx2(a, b, out, n);
+    else multiply_sse(a, b, out, n);
+#elif SPEAK_SIMD_NEON
+    multiply_neon(a, b, out, n);
+#else
+    for (size_t i = 0; i < n; ++i) out[i] = a[i] * b[i];
+#endif
+}
+
+void Simd::power(const float* re, const float* im, float* out, size_t n) {
+#if SPEAK_SIMD_X86
+    if (g_avx2) power_avx2(re, im, out, n);
+    else power_sse(re, im, out, n);
+#elif SPEAK_SIMD_NEON
+    power_neon(re, im, out, n);
+#else
+    for (size_t i = 0; i < n; ++i) out[i] = re[i] * re[i] + im[i] * im[i];
+#endif
+}
+
+size_t Simd::zero_crossings(const float* x, size_t n) {
+#if SPEAK_SIMD_X86
+    return g_avx2 ? zero_crossings_avx2(x, n) : zero_crossings_sse(x, n);
+#elif SPEAK_SIMD_NEON
+    return zero_crossings_neon(x, n);
+#else
+    size_t count = 0;
+    for (size_t i = 0; i + 1 < n; ++i) count += std::signbit(x[i]) != std::signbit(x[i + 1]);
+    return count;
+#endif
+}
+
+void Simd::s16_to_float(const int16_t* in, float* out, size_t n) {
+#if SPEAK_SIMD_X86
+    if (g_avx2) s16_to_float_avx2(in, out, n);
+    else s16_to_float_sse(in, out, n);
+#elif SPEAK_SIMD_NEON
+    s16_to_float_neon(in, out, n);
+#else
+    for (size_t i = 0; i < n; ++i) out[i] = static_cast<float>(in[i]) / S16_SCALE;
+#endif
+}
+
+void Simd::float_to_s16(const float* in, int16_t* out, size_t n) {
+#if SPEAK_SIMD_X86
+    if (g_avx2) float_to_s16_avx2(in, out, n);
+    else float_to_s16_sse(in, out, n);
+#elif SPEAK_SIMD_NEON
+    float_to_s16_neon(in, out, n);
+#else
+    for (size_t i = 0; i < n; ++i) out[i] = s16_from_float(in[i]);
+#endif
+}
+
+const char* Simd::isa_name() {
+#if SPEAK_SIMD_X86
+    return g_avx2 ? "avx2" : "sse2";
+#elif SPEAK_SIMD_NEON
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
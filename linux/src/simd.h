@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Vectorised kernels for the audio path. Each entry point picks AVX2+FMA or
+// SSE on x86-64 at runtime and NEON on ARM, with a scalar fallback, so the
+// binary does not need to be built for the host CPU.
+namespace Simd {
+    float dot(const float* a, const float* b, size_t n);
+
+    // out[i] = a[i] * b[i]
+    void multiply(const float* a, const float* b, float* out, size_t n);
+    // out[i] = re[i]^2 + im[i]^2
+    void power(const float* re, const float* im, float* out, size_t n);
+    // Sign changes between consecutive samples.
+    size_t zero_crossings(const float* x, size_t n);
+
+    // 16-bit PCM <-> float in [-1, 1). float_to_s16 rounds to nearest and
+    // saturates.
+    void s16_to_float(const int16_t* in, float* out, size_t n);
+    void float_to_s16(const float* in, int16_t* out, size_t n);
+
+    const char* isa_name();
+}
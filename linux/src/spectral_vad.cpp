@@ -0,0 +1,112 @@
+#include "spectral_vad.h"
+#include "simd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static constexpr float PI = 3.14159265358979f;
+
+void SpectralAnalyzer::configure(int sample_rate, size_t frame_size) {
+    size_t n = 1;
+    size_t log2n = 0;
+    while (n < frame_size) { n <<= 1; ++log2n; }
+    if (sample_rate == sample_rate_ && n == n_) return;
+
+    sample_rate_ = sample_rate;
+    n_ = n;
+    log2n_ = log2n;
+
+    // Periodic Hann over the real frame; the zero-padded tail stays zero.
+    window_.assign(n_, 0.0f);
+    for (size_t i = 0; i < frame_size; ++i) {
+        window_[i] = 0.5f - 0.5f * std::cos(2.0f * PI * static_cast<float>(i) / static_cast<float>(frame_size));
+    }
+
+    re_.assign(n_, 0.0f);
+    im_.assign(n_, 0.0f);
+    power_.assign(n_ / 2 + 1, 0.0f);
+
+    cos_.resize(n_ / 2);
+    sin_.resize(n_ / 2);
+    for (size_t k = 0; k < n_ / 2; ++k) {
+        cos_[k] = std::cos(2.0f * PI * static_cast<float>(k) / static_cast<float>(n_));
+        sin_[k] = -std::sin(2.0f * PI * static_cast<float>(k) / static_cast<float>(n_));
+    }
+
+    bitrev_.resize(n_);
+    for (size_t i = 0; i < n_; ++i) {
+        unsigned r = 0;
+        for (size_t b = 0; b < log2n_; ++b) r |= ((i >> b) & 1u) << (log2n_ - 1 - b);
+        bitrev_[i] = r;
+    }
+
+    float bin_hz = static_cast<float>(sample_rate_) / static_cast<float>(n_);
+    band_lo_ = static_cast<size_t>(std::ceil(BAND_LO_HZ / bin_hz));
+    band_hi_ = std::min(n_ / 2, static_cast<size_t>(BAND_HI_HZ / bin_hz));
+}
+
+// In-place iterative radix-2 over re_/im_, input already in bit-reversed order.
+void SpectralAnalyzer::fft() {
+    for (size_t half = 1, step = n_ / 2; half < n_; half <<= 1, step >>= 1) {
+        for (size_t start = 0; start < n_; start += half << 1) {
+            for (size_t k = 0; k < half; ++k) {
+                float wr = cos_[k * step];
+                float wi = sin_[k * step];
+                size_t a = start + k;
+                size_t b = a + half;
+                float tr = re_[b] * wr - im_[b] * wi;
+                float ti = re_[b] * wi + im_[b] * wr;
+                re_[b] = re_[a] - tr;
+                im_[b] = im_[a] - ti;
+                re_[a] += tr;
+                im_[a] += ti;
+            }
+        }
+    }
+}
+
+SpectralFeatures SpectralAnalyzer::analyze(const float* frame, size_t len) {
+    SpectralFeatures f;
+    len = std::min(len, n_);
+    if (len < 2) return f;
+
+    f.rms = std::sqrt(Simd::dot(frame, frame, len) / static_cast<float>(len));
+    f.zcr_hz = static_cast<float>(Simd::zero_crossings(frame, len)) * 0.5f
+             * static_cast<float>(sample_rate_) / static_cast<float>(len);
+
+    // Window into the imaginary buffer as scratch, then scatter into
+    // bit-reversed order for the FFT.
+    Simd::multiply(frame, window_.data(), im_.data(), len);
+    std::memset(re_.data(), 0, n_ * sizeof(float));
+    for (size_t i = 0; i < len; ++i) re_[bitrev_[i]] = im_[i];
+    std::memset(im_.data(), 0, n_ * sizeof(float));
+    fft();
+
+    const size_t bins = n_ / 2 + 1;
+    Simd::power(re_.data(), im_.data(), power_.data(), bins);
+
+    float total = 0;
+    for (size_t k = 1; k < bins; ++k) total += power_[k];
+    if (total <= 0 || band_hi_ <= band_lo_) return f;
+
+    float band = 0;
+    float log_sum = 0;
+    const float eps = 1e-12f;
+    for (size_t k = band_lo_; k <= band_hi_; ++k) {
+        band += power_[k];
+        log_sum += std::log(power_[k] + eps);
+    }
+    float count = static_cast<float>(band_hi_ - band_lo_ + 1);
+    f.band_ratio = band / total;
+    f.flatness = std::exp(log_sum / count) / (band / count + eps);
+
+    // Voiced speech puts a good share of its energy in the band (F0 itself
+    // often sits below it), with a peaky harmonic spectrum and a crossing
+    // rate near a voice's dominant frequency. Band share gates the rest:
+    // flatness means nothing for a band that is empty.
+    float s_band = std::clamp((f.band_ratio - 0.15f) / 0.35f, 0.0f, 1.0f);
+    float s_flat = std::clamp((0.6f - f.flatness) / 0.5f, 0.0f, 1.0f);
+    float s_zcr = (f.zcr_hz >= 80.0f && f.zcr_hz <= 3500.0f) ? 1.0f : 0.0f;
+    f.score = s_band * (0.2f + 0.55f * s_flat + 0.25f * s_zcr);
+    return f;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+struct SpectralFeatures {
+    float rms = 0;
+    float zcr_hz = 0;      // zero crossings as a frequency: crossings / 2 per second
+    float band_ratio = 0;  // share of spectral energy in 300-3400 Hz
+    float flatness = 1;    // geometric / arithmetic mean of the band's power; ~1 for noise
+    float score = 0;       // combined speech likelihood, 0..1
+};
+
+// Cheap non-neural frame features for the VAD: zero-crossing rate, telephone
+// band energy from a Hann-windowed radix-2 FFT, and spectral flatness over
+// that band. Sits between plain RMS and Silero in cost and robustness:
+// mains hum and rumble fall outside the band, while fans, HVAC and key
+// clicks are broadband and come out flat.
+//
+// All buffers are sized in configure(); analyze() does not allocate.
+class SpectralAnalyzer {
+public:
+    static constexpr float BAND_LO_HZ = 300.0f;
+    static constexpr float BAND_HI_HZ = 3400.0f;
+
+    // Prepares for frames of up to `frame_size` samples at `sample_rate`.
+    void configure(int sample_rate, size_t frame_size);
+
+    SpectralFeatures analyze(const float* frame, size_t len);
+
+    size_t fft_size() const { return n_; }
+
+private:
+    int sample_rate_ = 0;
+    size_t n_ = 0;
+    size_t log2n_ = 0;
+    size_t band_lo_ = 0;
+    size_t band_hi_ = 0;
+    std::vector<float> window_;
+    std::vector<float> re_;
+    std::vector<float> im_;
+    std::vector<float> power_;
+    std::vector<float> cos_;
+    std::vector<float> sin_;
+    std::vector<unsigned> bitrev_;
+
+    void fft();
+};
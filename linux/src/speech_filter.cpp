@@ -0,0 +1,76 @@
+#include "speech_filter.h"
+#include "whisper.h"
+#include <algorithm>
+#include <cstdio>
+
+void SpeechMap::add(size_t start, size_t end, size_t merge_gap) {
+    if (end <= start) return;
+    if (!spans_.empty()) {
+        Span& last = spans_.back();
+        size_t last_end = last.source + last.length;
+        if (start <= last_end + merge_gap) {
+            if (end > last_end) last.length = end - last.source;
+            return;
+        }
+    }
+    spans_.push_back({start, end - start, speech_samples()});
+}
+
+size_t SpeechMap::to_source(size_t packed) const {
+    if (spans_.empty()) return packed;
+    auto it = std::upper_bound(spans_.begin(), spans_.end(), packed,
+                               [](size_t p, const Span& s) { return p < s.packed; });
+    if (it != spans_.begin()) --it;
+    return it->source + std::min(packed - it->packed, it->length);
+}
+
+SpeechFilter::~SpeechFilter() {
+    if (ctx_) whisper_vad_free(ctx_);
+}
+
+bool SpeechFilter::load(const std::string& model_path) {
+    if (ctx_) return true;
+    auto cparams = whisper_vad_default_context_params();
+    cparams.n_threads = 1;
+    cparams.use_gpu = false;
+    ctx_ = whisper_vad_init_from_file_with_params(model_path.c_str(), cparams);
+    if (!ctx_) {
+        fprintf(stderr, "[SpeechFilter] Failed to load %s\n", model_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool SpeechFilter::scan(const RecordingStore& recording, SpeechMap& map) {
+    map.clear();
+    if (!ctx_) return false;
+
+    auto params = whisper_vad_default_params();
+    params.threshold = threshold;
+    params.min_speech_duration_ms = min_speech_ms;
+    params.min_silence_duration_ms = min_silence_ms;
+    params.speech_pad_ms = pad_ms;
+
+    // Speech running over a window edge comes back as two segments that end
+    // and start near the edge; the padding on each side is enough to rejoin them.
+    const size_t merge_gap = static_cast<size_t>(std::max(0, pad_ms)) * 2 * 16;
+
+    window_.resize(std::min(WINDOW, recording.size()));
+    for (size_t offset = 0; offset < recording.size(); offset += WINDOW) {
+        size_t n = recording.read(offset, std::min(WINDOW, recording.size() - offset), window_.data());
+        if (n == 0) break;
+
+        whisper_vad_segments* segs = whisper_vad_segments_from_samples(ctx_, params, window_.data(), static_cast<int>(n));
+        if (!segs) return false;
+
+        // Segment times are in centiseconds.
+        int count = whisper_vad_segments_n_segments(segs);
+        for (int i = 0; i < count; ++i) {
+            auto t0 = static_cast<size_t>(std::max(0.0f, whisper_vad_segments_get_segment_t0(segs, i)) * 160.0f);
+            auto t1 = static_cast<size_t>(std::max(0.0f, whisper_vad_segments_get_segment_t1(segs, i)) * 160.0f);
+            map.add(offset + std::min(t0, n), offset + std::min(t1, n), merge_gap);
+        }
+        whisper_vad_free_segments(segs);
+    }
+    return true;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "recording_store.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+struct whisper_vad_context;
+
+// The speech in a recording as spans of 16 kHz samples, and the mapping
+// from the audio packed out of those spans back to the recording.
+class SpeechMap {
+public:
+    struct Span {
+        size_t source;  // start in the recording
+        size_t length;
+        size_t packed;  // start in the packed audio
+    };
+
+    // Spans go in in order. One starting within `merge_gap` samples of the
+    // previous one's end extends it instead.
+    void add(size_t start, size_t end, size_t merge_gap = 0);
+    void clear() { spans_.clear(); }
+
+    const std::vector<Span>& spans() const { return spans_; }
+    bool empty() const { return spans_.empty(); }
+    size_t speech_samples() const { return spans_.empty() ? 0 : spans_.back().packed + spans_.back().length; }
+
+    // Recording position of a packed position. A position on the seam
+    // between two spans maps to the start of the later one.
+    size_t to_source(size_t packed) const;
+
+private:
+    std::vector<Span> spans_;
+};
+
+// Second, accurate speech pass over a finished recording: Silero through
+// whisper.cpp's whole-buffer VAD (whisper_vad_segments_from_samples),
+// where the live VAD only has to be cheap. The store is read WINDOW
+// samples at a time, so a spilled recording is never in memory as a whole.
+class SpeechFilter {
+public:
+    static constexpr size_t WINDOW = 16000 * 120;
+
+    float threshold = 0.5f;
+    int min_speech_ms = 250;
+    int min_silence_ms = 500;
+    int pad_ms = 200;
+
+    SpeechFilter() = default;
+    ~SpeechFilter();
+
+    SpeechFilter(const SpeechFilter&) = delete;
+    SpeechFilter& operator=(const SpeechFilter&) = delete;
+
+    bool load(const std::string& model_path);
+    bool loaded() const { return ctx_ != nullptr; }
+
+    // Fills `map` with the speech in `recording`. Returns false if the model
+    // failed on any window, in which case the map is incomplete.
+    bool scan(const RecordingStore& recording, SpeechMap& map);
+
+private:
+    whisper_vad_context* ctx_ = nullptr;
+    std::vector<float> window_;
+};
@@ -0,0 +1,83 @@
+#include "thread_priority.h"
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+static constexpr int FALLBACK_NICE = -10;
+
+static std::string describe_current() {
+    int policy = 0;
+    sched_param sp{};
+    if (pthread_getschedparam(pthread_self(), &policy, &sp) == 0 &&
+        (policy == SCHED_FIFO || policy == SCHED_RR)) {
+        return std::string(policy == SCHED_FIFO ? "SCHED_FIFO " : "SCHED_RR ") + std::to_string(sp.sched_priority);
+    }
+    errno = 0;
+    int nice = getpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)));
+    if (errno == 0 && nice != 0) return "nice " + std::to_string(nice);
+    return "normal";
+}
+
+std::string ThreadPriority::promote_current(int rt_priority) {
+    int policy = 0;
+    sched_param sp{};
+    if (pthread_getschedparam(pthread_self(), &policy, &sp) == 0 &&
+        (policy == SCHED_FIFO || policy == SCHED_RR)) {
+        return describe_current();
+    }
+
+    int lo = sched_get_priority_min(SCHED_FIFO);
+    int hi = sched_get_priority_max(SCHED_FIFO);
+    sp.sched_priority = rt_priority < lo ? lo : rt_priority > hi ? hi : rt_priority;
+    int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp);
+    if (err == 0) return describe_current();
+
+    fprintf(stderr, "[ThreadPriority] SCHED_FIFO %d refused (%s); raise rtprio in limits.conf "
+            "or grant CAP_SYS_NICE. Trying nice %d\n", sp.sched_priority, std::strerror(err), FALLBACK_NICE);
+
+    // On Linux nice values are per thread when addressed by tid.
+    if (setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), FALLBACK_NICE) != 0) {
+        fprintf(stderr, "[ThreadPriority] nice %d refused (%s), staying at normal priority\n",
+                FALLBACK_NICE, std::strerror(errno));
+    }
+    return describe_current();
+}
+
+bool ThreadPriority::pin_current(int cpu) {
+    if (cpu < 0 || cpu >= CPU_SETSIZE) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (err != 0) {
+        fprintf(stderr, "[ThreadPriority] Cannot pin to CPU %d: %s\n", cpu, std::strerror(err));
+        return false;
+    }
+    return true;
+}
+
+bool ThreadPriority::exclude_cpu(int cpu) {
+    if (cpu < 0 || cpu >= CPU_SETSIZE) return false;
+    cpu_set_t set;
+    if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) != 0) return false;
+    if (!CPU_ISSET(cpu, &set)) return true;
+
+    // Never leave the thread with nowhere to run.
+    if (CPU_COUNT(&set) < 2) {
+        fprintf(stderr, "[ThreadPriority] CPU %d is the only one available, not reserving it\n", cpu);
+        return false;
+    }
+
+    CPU_CLR(cpu, &set);
+    int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (err != 0) {
+        fprintf(stderr, "[ThreadPriority] Cannot exclude CPU %d: %s\n", cpu, std::strerror(err));
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <string>
+
+// Scheduling helpers for the calling thread. Everything here degrades
+// gracefully: failures are reported, never fatal.
+namespace ThreadPriority {
+    // Moves the calling thread to SCHED_FIFO at `rt_priority`, or failing
+    // that (no CAP_SYS_NICE / RLIMIT_RTPRIO) to a raised nice level. A thread
+    // that is already real-time, e.g. PipeWire's data thread, is left alone.
+    // Returns what is in effect afterwards, for status output.
+    std::string promote_current(int rt_priority);
+
+    bool pin_current(int cpu);
+
+    // Drops `cpu` from the calling thread's affinity mask. Threads it creates
+    // afterwards, including whisper's workers, inherit the reduced mask.
+    bool exclude_cpu(int cpu);
+}
@@ -1,7 +1,11 @@
 #include "transcription_pipeline.h"
 #include "text_output.h"
+#include "thread_priority.h"
+#include "simd.h"
 #include <algorithm>
 #include <chrono>
+#include <mutex>
+#include <stdexcept>
 
 static const char* HALLUCINATION_PATTERNS[] = {
     "thank you", "thanks for watching", "thanks for listening",
@@ -11,7 +15,9 @@ static const char* HALLUCINATION_PATTERNS[] = {
 
 TranscriptionPipeline::TranscriptionPipeline() {
     settings_ = Settings::load();
+    cache_.budget_mb = settings_.model_cache_mb;
     apply_vad_settings();
+    apply_audio_settings();
 }
 
 TranscriptionPipeline::~TranscriptionPipeline() {
@@ -21,115 +27,255 @@ TranscriptionPipeline::~TranscriptionPipeline() {
 void TranscriptionPipeline::apply_vad_settings() {
     auto& vad = audio_.vad();
     vad.is_enabled = settings_.vad_enabled;
-    vad.speech_threshold = settings_.vad_speech_threshold;
-    vad.silence_threshold = settings_.vad_silence_threshold;
-    vad.min_speech_duration_ms = settings_.vad_min_speech_ms;
-    vad.min_silence_duration_ms = settings_.vad_min_silence_ms;
-    vad.pre_speech_padding_ms = settings_.vad_pre_padding_ms;
-    vad.post_speech_padding_ms = settings_.vad_post_padding_ms;
+    vad.apply(settings_);
+
+    vad.backend = settings_.vad_backend == VadBackend::spectral ? VadBackend::spectral : VadBackend::energy;
+    if (settings_.vad_backend == VadBackend::silero) {
+        std::string path = ModelManager::vad_model_path();
+        if (!path.empty() && vad.load_silero(path)) {
+            vad.backend = VadBackend::silero;
+        } else {
+            fprintf(stderr, "[Pipeline] Silero VAD model not available, using energy VAD\n");
+        }
+    }
+}
+
+void TranscriptionPipeline::apply_audio_settings() {
+    audio_.capture_format = settings_.capture_format;
+    audio_.backend = settings_.audio_backend;
+    audio_.frame_ms = settings_.capture_frame_ms;
+    audio_.pre_roll_ms = settings_.pre_roll_ms;
+    audio_.recording_ram_limit_mb = settings_.recording_ram_limit_mb;
+    audio_.realtime = settings_.capture_realtime;
+    audio_.rt_priority = settings_.capture_rt_priority;
+    audio_.capture_cpu = settings_.capture_cpu;
+
+    // Keep the capture core free of inference: every thread started from
+    // here on (transcription threads and whisper's workers) inherits this mask.
+    if (settings_.capture_cpu >= 0) ThreadPriority::exclude_cpu(settings_.capture_cpu);
 }
 
 void TranscriptionPipeline::start_recording() {
     if (recording_) return;
     last_context_text_.clear();
     did_output_ = false;
+    auto ctx = context();
+    audio_.mel_bins = settings_.incremental_mel && ctx &&
+                      settings_.transcription_mode == TranscriptionMode::buffered ? ctx->n_mels() : 0;
+    if (audio_.mel_bins > 0) audio_.mel_filters = ctx->mel_filters();
     audio_.start_recording();
     recording_ = true;
 
-    if (settings_.transcription_mode == TranscriptionMode::continuous) {
+    if (settings_.transcription_mode != TranscriptionMode::buffered) {
         start_continuous_monitor();
         fprintf(stderr, "[Pipeline] Continuous monitor started\n");
     }
 
     fprintf(stderr, "[Pipeline] Recording started (mode: %s, vad: %s)\n",
-            settings_.transcription_mode == TranscriptionMode::continuous ? "continuous" : "buffered",
-            settings_.vad_enabled ? "on" : "off");
+            transcription_mode_name(settings_.transcription_mode),
+            settings_.vad_enabled ? vad_backend_name(audio_.vad().backend) : "off");
 }
 
 TranscriptionResult TranscriptionPipeline::stop_recording_and_transcribe() {
     if (!recording_) return {};
 
     stop_continuous_monitor();
-    auto samples = audio_.stop_recording();
+    auto recording = audio_.stop_recording();
     if (!settings_.keep_mic_warm) audio_.release();
     recording_ = false;
 
-    if (static_cast<int>(samples.size()) < MIN_SAMPLES) return {};
+    MelSpectrogram mel;
+    bool have_mel = audio_.take_mel(mel);
+    if (static_cast<int>(recording->size()) < MIN_SAMPLES) return {};
 
-    return transcribe_and_output(samples);
+    return transcribe_and_output(*recording, have_mel ? &mel : nullptr);
 }
 
 void TranscriptionPipeline::shutdown() {
     stop_continuous_monitor();
-    ctx_.reset();
+    // A load cannot be cancelled; let it finish rather than free the
+    // pipeline under it.
+    {
+        std::lock_guard<std::mutex> lk(loader_mu_);
+        if (loader_thread_.joinable()) loader_thread_.join();
+    }
+    {
+        std::lock_guard<std::mutex> lk(ctx_mu_);
+        ctx_.reset();
+        model_.reset();
+    }
+    cache_.clear();
     audio_.release();
 }
 
+std::shared_ptr<WhisperContext> TranscriptionPipeline::context() const {
+    std::lock_guard<std::mutex> lk(ctx_mu_);
+    return ctx_;
+}
+
+std::shared_ptr<WhisperContext> TranscriptionPipeline::context_for(size_t n_samples) {
+    if (!settings_.long_model.empty() &&
+        n_samples >= static_cast<size_t>(std::max(0, settings_.long_model_after_ms)) * 16) {
+        if (auto ctx = cache_.get(settings_.long_model)) return ctx;
+    }
+    return context();
+}
+
+// The previous context is only freed here if no job holds it, and then
+// after the lock is dropped (`old` outlives `lk`); otherwise the last job
+// to finish frees it.
+void TranscriptionPipeline::install(std::shared_ptr<WhisperContext> ctx, const WhisperModel& model) {
+    std::shared_ptr<WhisperContext> old;
+    std::lock_guard<std::mutex> lk(ctx_mu_);
+    old = std::move(ctx_);
+    ctx_ = std::move(ctx);
+    model_ = model;
+}
+
 void TranscriptionPipeline::load_model(const WhisperModel& model) {
-    ctx_ = models_.load(model, settings_);
-    ctx_->warmup();
+    auto ctx = cache_.load(model, settings_, true);
+    models_.select(model.id);
+    install(std::move(ctx), model);
     fprintf(stderr, "[Pipeline] Model loaded and warmed up: %s\n", model.name().c_str());
 }
 
 void TranscriptionPipeline::load_first_available() {
-    ctx_ = models_.load_saved_or_first(settings_);
-    ctx_->warmup();
-    auto* m = models_.current();
-    if (m) fprintf(stderr, "[Pipeline] Auto-loaded and warmed up: %s\n", m->name().c_str());
+    auto* m = models_.saved_or_first();
+    if (!m) throw std::runtime_error("No models found");
+    WhisperModel model = *m;
+    auto ctx = cache_.load(model, settings_, true);
+    models_.select(model.id);
+    install(std::move(ctx), model);
+    fprintf(stderr, "[Pipeline] Auto-loaded and warmed up: %s\n", model.name().c_str());
+}
+
+bool TranscriptionPipeline::load_model_async(const WhisperModel& model) {
+    return start_load(model, true);
+}
+
+bool TranscriptionPipeline::preload_model_async(const WhisperModel& model) {
+    return start_load(model, false);
+}
+
+// Builds the context outside models_, whose list belongs to the control
+// thread; only select() is called from the loader. A resident model is
+// switched to on the spot.
+bool TranscriptionPipeline::start_load(const WhisperModel& model, bool activate) {
+    // The loader clears loading_ before its thread exits, so loading_ alone
+    // does not keep two callers from joining and replacing it at once.
+    std::lock_guard<std::mutex> loader_lk(loader_mu_);
+    auto resident = cache_.get(model.id);
+    {
+        std::lock_guard<std::mutex> lk(ctx_mu_);
+        if (!loading_.empty()) return false;
+        if (!resident) loading_ = model.name();
+    }
+    if (resident) {
+        if (activate) {
+            cache_.pin(model.id);
+            install(std::move(resident), model);
+            models_.select(model.id);
+            fprintf(stderr, "[Pipeline] Switched to resident %s\n", model.name().c_str());
+        }
+        return true;
+    }
+    if (loader_thread_.joinable()) loader_thread_.join();
+
+    Settings settings = settings_;
+    loader_thread_ = std::thread([this, model, settings, activate]() {
+        auto start = std::chrono::steady_clock::now();
+        std::string error;
+        try {
+            auto ctx = cache_.load(model, settings, activate);
+            if (activate) {
+                install(std::move(ctx), model);
+                models_.select(model.id);
+            }
+        } catch (const std::exception& e) {
+            error = e.what();
+        }
+
+        std::lock_guard<std::mutex> lk(ctx_mu_);
+        loading_.clear();
+        load_error_ = error;
+        if (error.empty()) {
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            fprintf(stderr, "[Pipeline] %s %s (loaded and warmed up in %.0fms)\n",
+                    activate ? "Switched to" : "Preloaded", model.name().c_str(), ms);
+        } else {
+            fprintf(stderr, "[Pipeline] Failed to load %s: %s\n", model.name().c_str(), error.c_str());
+        }
+    });
+    return true;
+}
+
+std::optional<WhisperModel> TranscriptionPipeline::current_model() const {
+    std::lock_guard<std::mutex> lk(ctx_mu_);
+    return model_;
+}
+
+std::string TranscriptionPipeline::loading_model() const {
+    std::lock_guard<std::mutex> lk(ctx_mu_);
+    return loading_;
+}
+
+std::string TranscriptionPipeline::load_error() const {
+    std::lock_guard<std::mutex> lk(ctx_mu_);
+    return load_error_;
 }
 
 void TranscriptionPipeline::start_continuous_monitor() {
-    silence_frame_count_ = 0;
     continuous_running_ = true;
-    continuous_thread_ = std::thread(&TranscriptionPipeline::continuous_loop, this);
+    continuous_thread_ = std::thread(settings_.transcription_mode == TranscriptionMode::streaming
+                                         ? &TranscriptionPipeline::streaming_loop
+                                         : &TranscriptionPipeline::continuous_loop,
+                                     this);
 }
 
 void TranscriptionPipeline::stop_continuous_monitor() {
     continuous_running_ = false;
+    audio_.vad_events().wake();
     if (continuous_thread_.joinable()) continuous_thread_.join();
 }
 
+// Sleeps on the VAD's event queue and cuts a chunk as soon as an utterance
+// ends, or when the buffer grows past 25 s without a pause. With VAD off
+// there are no events, so every wakeup counts as a pause.
 void TranscriptionPipeline::continuous_loop() {
+    auto& events = audio_.vad_events();
+    bool pause_pending = false;
+
     while (continuous_running_) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(150));
+        events.wait(CONTINUOUS_POLL_MS);
         if (!continuous_running_) break;
 
-        auto& vad = audio_.vad();
-        size_t buf_count = audio_.raw_buffer().count();
-
-        if (vad.is_speaking) {
-            silence_frame_count_ = 0;
-        } else {
-            ++silence_frame_count_;
+        // A pause stays pending until a chunk is cut, even if speech has
+        // started again since: the audio up to here still ends one.
+        VadEvent ev;
+        while (events.pop(ev)) {
+            pause_pending |= ev.type == VadEvent::Type::speech_end;
         }
 
-        bool pause_detected = buf_count > 0 && silence_frame_count_ >= 3;
-        bool buffer_full = buf_count > static_cast<size_t>(audio_.hardware_sample_rate()) * 25;
+        size_t buf_count = audio_.recorded_samples();
+        bool pause_detected = buf_count > 0 && (pause_pending || !audio_.vad().is_enabled);
+        bool buffer_full = buf_count > 16000 * 25;
 
         if ((!pause_detected && !buffer_full) || transcribing_) continue;
+        if (buf_count < static_cast<size_t>(CONTINUOUS_MIN_SAMPLES)) continue;
 
-        size_t min_raw = static_cast<size_t>(CONTINUOUS_MIN_SAMPLES * audio_.hardware_sample_rate() / 16000);
-        if (buf_count < min_raw) continue;
-
-        auto raw = audio_.raw_buffer().drain();
-        auto resampled = audio_.resample_public(raw);
+        pause_pending = false;
+        auto samples = audio_.take_recorded();
 
         fprintf(stderr, "[Pipeline] Continuous: %zu samples (%.1fs)\n",
-                resampled.size(), static_cast<double>(resampled.size()) / 16000.0);
+                samples.size(), static_cast<double>(samples.size()) / 16000.0);
 
-        if (!ctx_) continue;
+        auto ctx = context();
+        if (!ctx) continue;
         transcribing_ = true;
         if (on_transcription_start) on_transcription_start();
 
-        const std::string* prompt_ptr = nullptr;
-        std::string prompt;
-        if (!last_context_text_.empty()) {
-            size_t start = last_context_text_.size() > 200 ? last_context_text_.size() - 200 : 0;
-            prompt = last_context_text_.substr(start);
-            prompt_ptr = &prompt;
-        }
-
-        auto result = ctx_->transcribe(resampled, prompt_ptr);
+        std::string prompt = context_prompt();
+        auto result = ctx->transcribe(samples, prompt.empty() ? nullptr : &prompt);
         transcribing_ = false;
 
         std::string text = result.full_text();
@@ -157,6 +303,119 @@ void TranscriptionPipeline::continuous_loop() {
     }
 }
 
+std::string TranscriptionPipeline::context_prompt() const {
+    size_t start = last_context_text_.size() > 200 ? last_context_text_.size() - 200 : 0;
+    return last_context_text_.substr(start);
+}
+
+void TranscriptionPipeline::commit_words(const std::vector<std::string>& words) {
+    if (words.empty()) return;
+    std::string text;
+    for (auto& w : words) text += w + " ";
+    output_text(text);
+
+    last_context_text_ += " " + text;
+    if (last_context_text_.size() > 500) {
+        last_context_text_ = last_context_text_.substr(last_context_text_.size() - 300);
+    }
+}
+
+// Streaming mode: keeps the current utterance as a window, re-decodes it
+// every stream_step_ms and types the words LocalAgreement commits, so text
+// shows up while the user is still talking. Once a leading whisper segment
+// is wholly committed its audio is dropped from the window. A VAD pause,
+// or the window reaching STREAM_MAX_SAMPLES, commits the rest and starts a
+// new window.
+void TranscriptionPipeline::streaming_loop() {
+    auto& events = audio_.vad_events();
+    LocalAgreement agreement;
+    std::vector<float> window;
+    bool active = false;
+    // Held for a whole window, so hypotheses from two models are never
+    // compared after a switch.
+    std::shared_ptr<WhisperContext> ctx;
+
+    auto decode = [&]() {
+        transcribing_ = true;
+        std::string prompt = context_prompt();
+        auto result = ctx->transcribe(window, prompt.empty() ? nullptr : &prompt);
+        transcribing_ = false;
+        if (is_hallucination(result.full_text())) result.segments.clear();
+        return result;
+    };
+
+    // A pause before anything was decoded and while the window is under
+    // STREAM_MIN_SAMPLES keeps the window, so a short utterance ("yes") goes
+    // out with the next one rather than being dropped, as in continuous
+    // mode. `last` is the end of the recording, where only MIN_SAMPLES is
+    // needed.
+    auto finish = [&](bool last) {
+        size_t min = static_cast<size_t>(last ? MIN_SAMPLES : STREAM_MIN_SAMPLES);
+        if (!active && window.size() < min) {
+            if (last) window.clear();
+            return;
+        }
+        if (!ctx) ctx = context();
+        if (ctx && !window.empty()) {
+            if (!active && on_transcription_start) on_transcription_start();
+            active = true;
+            agreement.update(LocalAgreement::split_words(decode().full_text()));
+        }
+        commit_words(agreement.flush());
+        agreement.reset();
+        window.clear();
+        ctx.reset();
+        if (active && on_transcription_end) on_transcription_end();
+        active = false;
+    };
+
+    while (continuous_running_) {
+        events.wait(std::max(50, settings_.stream_step_ms));
+
+        bool pause = false;
+        VadEvent ev;
+        while (events.pop(ev)) pause = ev.type == VadEvent::Type::speech_end;
+
+        auto fresh = audio_.take_recorded();
+        window.insert(window.end(), fresh.begin(), fresh.end());
+        if (!continuous_running_) break;
+
+        if (pause || window.size() >= static_cast<size_t>(STREAM_MAX_SAMPLES)) {
+            finish(false);
+            continue;
+        }
+        if (window.size() < static_cast<size_t>(STREAM_MIN_SAMPLES)) continue;
+        if (!ctx) ctx = context();
+        if (!ctx) continue;
+
+        if (!active && on_transcription_start) on_transcription_start();
+        active = true;
+
+        auto result = decode();
+        commit_words(agreement.update(LocalAgreement::split_words(result.full_text())));
+
+        // Drop leading segments whose words are all committed; the last
+        // segment stays, since more audio may still extend it.
+        size_t words = 0, trim_words = 0;
+        int64_t trim_ms = 0;
+        for (size_t i = 0; i + 1 < result.segments.size(); ++i) {
+            words += LocalAgreement::split_words(result.segments[i].text).size();
+            if (words > agreement.committed()) break;
+            trim_words = words;
+            trim_ms = result.segments[i].end_time;
+        }
+        size_t trim = std::min(window.size(), static_cast<size_t>(std::max<int64_t>(0, trim_ms)) * 16);
+        if (trim > 0) {
+            window.erase(window.begin(), window.begin() + static_cast<std::ptrdiff_t>(trim));
+            agreement.trim(trim_words);
+        }
+    }
+
+    auto rest = audio_.take_recorded();
+    window.insert(window.end(), rest.begin(), rest.end());
+    finish(true);
+}
+
 bool TranscriptionPipeline::is_hallucination(const std::string& text) {
     std::string lower = text;
     for (auto& c : lower) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
@@ -170,17 +429,34 @@ bool TranscriptionPipeline::is_hallucination(const std::string& text) {
     return false;
 }
 
-TranscriptionResult TranscriptionPipeline::transcribe_and_output(const std::vector<float>& samples) {
-    if (!ctx_) return {};
+TranscriptionResult TranscriptionPipeline::transcribe_and_output(const RecordingStore& recording, const MelSpectrogram* mel) {
+    auto ctx = context_for(recording.size());
+    if (!ctx) return {};
 
     transcribing_ = true;
     if (on_transcription_start) on_transcription_start();
 
     TranscriptionResult result;
-    if (static_cast<int>(samples.size()) > MAX_CHUNK_SAMPLES) {
-        result = transcribe_chunked(samples);
+    if (static_cast<int>(recording.size()) > MAX_CHUNK_SAMPLES) {
+        // Without a speech pass the whole recording is one span, and with
+        // one state as well there is nothing to plan ahead.
+        SpeechMap speech;
+        bool filtered = settings_.vad_prefilter && find_speech(recording, speech);
+        if (!filtered && ctx->max_states() == 1) {
+            result = transcribe_sequential(*ctx, recording);
+        } else {
+            if (!filtered) {
+                speech.clear();
+                speech.add(0, recording.size());
+            }
+            result = transcribe_chunked(*ctx, recording, speech);
+        }
+    } else if (mel && mel->n_samples == recording.size() && mel->n_mel == ctx->n_mels()) {
+        // The mel check covers a switch, or routing, to a model with a
+        // different filterbank than the one recording started with.
+        result = ctx->transcribe(*mel);
     } else {
-        result = ctx_->transcribe(samples);
+        result = ctx->transcribe(recording.read(0, recording.size()));
     }
 
     perf_.record(result);
@@ -208,27 +484,200 @@ void TranscriptionPipeline::output_text(const std::string& text) {
     }
 }
 
-TranscriptionResult TranscriptionPipeline::transcribe_chunked(const std::vector<float>& samples) {
+bool TranscriptionPipeline::find_speech(const RecordingStore& recording, SpeechMap& map) {
+    if (!speech_filter_.loaded()) {
+        std::string path = ModelManager::vad_model_path();
+        if (path.empty() || !speech_filter_.load(path)) {
+            fprintf(stderr, "[Pipeline] Silero VAD model not available, not pre-filtering\n");
+            return false;
+        }
+    }
+    speech_filter_.threshold = settings_.vad_speech_probability;
+    speech_filter_.pad_ms = settings_.vad_pre_padding_ms;
+
     auto start = std::chrono::steady_clock::now();
+    bool ok = speech_filter_.scan(recording, map);
+    double elapsed = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    if (!ok) {
+        fprintf(stderr, "[Pipeline] Pre-filter failed, transcribing everything\n");
+        return false;
+    }
+
+    fprintf(stderr, "[Pipeline] Pre-filter: %.1fs of speech in %.1fs, %zu spans (%.0fms)\n",
+            static_cast<double>(map.speech_samples()) / 16000.0,
+            static_cast<double>(recording.size()) / 16000.0, map.spans().size(), elapsed);
+    return true;
+}
+
+// Copies packed positions [packed, packed + count) out of the spans of
+// `map` into `out`; returns how many samples were copied.
+static size_t read_packed(const RecordingStore& recording, const SpeechMap& map,
+                          size_t packed, size_t count, float* out) {
+    const auto& spans = map.spans();
+    auto it = std::upper_bound(spans.begin(), spans.end(), packed,
+                               [](size_t p, const SpeechMap::Span& s) { return p < s.packed; });
+    if (it != spans.begin()) --it;
+
+    size_t done = 0;
+    for (; it != spans.end() && done < count; ++it) {
+        size_t skip = packed + done - it->packed;
+        if (skip >= it->length) continue;
+        size_t want = std::min(it->length - skip, count - done);
+        size_t got = recording.read(it->source + skip, want, out + done);
+        done += got;
+        if (got < want) break;
+    }
+    return done;
+}
+
+// Offset of the middle of the quietest 10 ms in `audio`, or `count` if it
+// is shorter than that.
+static size_t quietest_point(const float* audio, size_t count) {
+    const size_t hop = 160;
+    size_t cut = count;
+    float quietest = -1;
+    for (size_t i = 0; i + hop <= count; i += hop) {
+        float energy = Simd::dot(audio + i, audio + i, hop);
+        if (quietest < 0 || energy <= quietest) {
+            quietest = energy;
+            cut = i + hop / 2;
+        }
+    }
+    return cut;
+}
+
+// Cuts the packed audio into chunks of at most MAX_CHUNK_SAMPLES. A chunk
+// ends at the last span boundary in its second half if there is one (the
+// pre-filter already found silence there), otherwise at the quietest
+// 10 ms in its final CUT_SEARCH_SAMPLES, so words are not split.
+std::vector<TranscriptionPipeline::Chunk> TranscriptionPipeline::plan_chunks(
+        const RecordingStore& recording, const SpeechMap& map) {
+    const size_t total = map.speech_samples();
+    const size_t max_chunk = static_cast<size_t>(MAX_CHUNK_SAMPLES);
+    const size_t search = static_cast<size_t>(CUT_SEARCH_SAMPLES);
+
+    std::vector<Chunk> chunks;
+    std::vector<float> tail;
+    size_t begin = 0;
+    while (begin < total) {
+        size_t end = begin + max_chunk;
+        if (end >= total) {
+            chunks.push_back({begin, total});
+            break;
+        }
+
+        size_t cut = 0;
+        for (const auto& span : map.spans()) {
+            if (span.packed > end) break;
+            if (span.packed > begin + max_chunk / 2) cut = span.packed;
+        }
+
+        if (cut == 0) {
+            size_t from = end - search;
+            tail.resize(search);
+            tail.resize(read_packed(recording, map, from, search, tail.data()));
+            size_t at = quietest_point(tail.data(), tail.size());
+            cut = at < tail.size() ? from + at : end;
+        }
+
+        chunks.push_back({begin, cut});
+        begin = cut;
+    }
+    return chunks;
+}
+
+// One state and no speech map: chunks are cut as they are read rather
+// than planned up front. Each read of up to MAX_CHUNK_SAMPLES is cut at the
+// quietest 10 ms in its last CUT_SEARCH_SAMPLES and the rest carried into
+// the next chunk, so no audio is read twice.
+TranscriptionResult TranscriptionPipeline::transcribe_sequential(WhisperContext& ctx, const RecordingStore& recording) {
+    auto start = std::chrono::steady_clock::now();
+    double total_audio_ms = static_cast<double>(recording.size()) / 16.0;
+    const size_t max_chunk = static_cast<size_t>(MAX_CHUNK_SAMPLES);
+    const size_t search = static_cast<size_t>(CUT_SEARCH_SAMPLES);
+
     std::vector<TranscriptionSegment> all_segments;
-    double total_audio_ms = static_cast<double>(samples.size()) / 16.0;
+    std::vector<float> window, audio;
+    window.reserve(max_chunk);
+    audio.reserve(max_chunk);
+    size_t offset = 0;  // recording position of window[0]
+    size_t chunks = 0;
+    while (offset < recording.size()) {
+        size_t have = window.size();
+        window.resize(std::min(max_chunk, recording.size() - offset));
+        size_t got = have < window.size() ? recording.read(offset + have, window.size() - have, window.data() + have) : 0;
+        window.resize(have + got);
+        if (window.empty()) break;
+
+        size_t cut = window.size();
+        if (got > 0 && offset + window.size() < recording.size()) {
+            size_t from = window.size() > search ? window.size() - search : 0;
+            size_t at = quietest_point(window.data() + from, window.size() - from);
+            if (at < window.size() - from) cut = from + at;
+        }
+
+        audio.assign(window.begin(), window.begin() + static_cast<std::ptrdiff_t>(cut));
+        window.erase(window.begin(), window.begin() + static_cast<std::ptrdiff_t>(cut));
+        auto chunk = ctx.transcribe(audio);
+        ++chunks;
 
-    size_t offset = 0;
-    while (offset < samples.size()) {
-        size_t end = std::min(offset + static_cast<size_t>(MAX_CHUNK_SAMPLES), samples.size());
-        std::vector<float> chunk(samples.begin() + offset, samples.begin() + end);
-        auto chunk_result = ctx_->transcribe(chunk);
+        auto offset_ms = static_cast<int64_t>(offset / 16);
+        for (auto& seg : chunk.segments) {
+            all_segments.push_back({std::move(seg.text), seg.start_time + offset_ms, seg.end_time + offset_ms});
+        }
+        offset += cut;
+    }
 
-        int64_t offset_ms = static_cast<int64_t>(static_cast<double>(offset) / 16.0);
-        for (auto& seg : chunk_result.segments) {
-            all_segments.push_back({seg.text, seg.start_time + offset_ms, seg.end_time + offset_ms});
+    double elapsed = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    fprintf(stderr, "[Pipeline] %zu chunks in order on one state\n", chunks);
+    return {std::move(all_segments), total_audio_ms, elapsed, ctx.model_name()};
+}
+
+// Transcribes the planned chunks on as many threads as the context has
+// states, then stitches the segments in order with times mapped back onto
+// the recording. Store reads are serialised (RecordingStore is not
+// thread-safe); they are short next to a whisper_full call.
+TranscriptionResult TranscriptionPipeline::transcribe_chunked(WhisperContext& ctx, const RecordingStore& recording, const SpeechMap& map) {
+    auto start = std::chrono::steady_clock::now();
+    double total_audio_ms = static_cast<double>(recording.size()) / 16.0;
+
+    auto chunks = plan_chunks(recording, map);
+    std::vector<TranscriptionResult> results(chunks.size());
+    std::atomic<size_t> next{0};
+    std::mutex read_mu;
+
+    auto worker = [&]() {
+        std::vector<float> audio;
+        for (size_t i = next++; i < chunks.size(); i = next++) {
+            audio.resize(chunks[i].end - chunks[i].begin);
+            {
+                std::lock_guard<std::mutex> lk(read_mu);
+                audio.resize(read_packed(recording, map, chunks[i].begin, audio.size(), audio.data()));
+            }
+            if (!audio.empty()) results[i] = ctx.transcribe(audio);
+        }
+    };
+
+    size_t n_workers = std::min(chunks.size(), static_cast<size_t>(ctx.max_states()));
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < n_workers; ++i) workers.emplace_back(worker);
+    worker();
+    for (auto& t : workers) t.join();
+
+    std::vector<TranscriptionSegment> all_segments;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        for (auto& seg : results[i].segments) {
+            auto t0 = map.to_source(chunks[i].begin + static_cast<size_t>(std::max<int64_t>(0, seg.start_time)) * 16);
+            auto t1 = map.to_source(chunks[i].begin + static_cast<size_t>(std::max<int64_t>(0, seg.end_time)) * 16);
+            all_segments.push_back({std::move(seg.text), static_cast<int64_t>(t0 / 16), static_cast<int64_t>(t1 / 16)});
         }
-        offset = end;
     }
 
     double elapsed = std::chrono::duration<double, std::milli>(
         std::chrono::steady_clock::now() - start).count();
+    fprintf(stderr, "[Pipeline] %zu chunks on %zu states\n", chunks.size(), n_workers);
 
-    auto* m = models_.current();
-    return {std::move(all_segments), total_audio_ms, elapsed, m ? m->name() : "unknown"};
+    return {std::move(all_segments), total_audio_ms, elapsed, ctx.model_name()};
 }
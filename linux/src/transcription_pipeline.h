@@ -2,11 +2,16 @@
 
 #include "audio_engine.h"
 #include "model_manager.h"
+#include "model_cache.h"
 #include "whisper_context.h"
 #include "performance_monitor.h"
+#include "speech_filter.h"
+#include "local_agreement.h"
 #include "settings.h"
 #include <memory>
 #include <atomic>
+#include <mutex>
+#include <optional>
 #include <thread>
 #include <functional>
 
@@ -25,12 +30,28 @@ public:
     bool did_output_text() const { return did_output_; }
 
     void apply_vad_settings();
+    void apply_audio_settings();
     void start_recording();
     TranscriptionResult stop_recording_and_transcribe();
     void shutdown();
 
     void load_model(const WhisperModel& model);
     void load_first_available();
+    // Loads and warms `model` on a background thread, then swaps it in.
+    // Transcriptions already running finish on the old model, which is
+    // freed when the last of them ends. Returns false if a load is already
+    // in progress.
+    bool load_model_async(const WhisperModel& model);
+    // Loads `model` into the cache in the background without switching to
+    // it, for routing (long_model) or a later instant switch.
+    bool preload_model_async(const WhisperModel& model);
+    const ModelCache& model_cache() const { return cache_; }
+
+    // The model transcriptions run on, the one being loaded ("" if none)
+    // and why the last background load failed ("" if it did not).
+    std::optional<WhisperModel> current_model() const;
+    std::string loading_model() const;
+    std::string load_error() const;
 
     std::function<void()> on_transcription_start;
     std::function<void()> on_transcription_end;
@@ -40,7 +61,19 @@ private:
     ModelManager models_;
     PerformanceMonitor perf_;
     Settings settings_;
-    std::unique_ptr<WhisperContext> ctx_;
+    // Swapped by loads; every job takes its own reference through
+    // context() and keeps that model until it is done.
+    ModelCache cache_;
+    mutable std::mutex ctx_mu_;
+    std::shared_ptr<WhisperContext> ctx_;
+    std::optional<WhisperModel> model_;
+    std::string loading_;
+    std::string load_error_;
+    // Held while joining or starting loader_thread_, which the main and
+    // control threads can both do.
+    std::mutex loader_mu_;
+    std::thread loader_thread_;
+    SpeechFilter speech_filter_;
     std::string last_context_text_;
     std::atomic<bool> recording_{false};
     std::atomic<bool> transcribing_{false};
@@ -48,18 +81,43 @@ private:
 
     std::thread continuous_thread_;
     std::atomic<bool> continuous_running_{false};
-    int silence_frame_count_ = 0;
 
     static constexpr int MAX_CHUNK_SAMPLES = 480'000;
+    static constexpr int CUT_SEARCH_SAMPLES = 80'000;
     static constexpr int MIN_SAMPLES = 8'000;
     static constexpr int CONTINUOUS_MIN_SAMPLES = 24'000;
+    // Only bounds how late the buffer-full check runs; pauses wake the
+    // worker through VAD events.
+    static constexpr int CONTINUOUS_POLL_MS = 250;
+    // Streaming: shortest window worth decoding, and the longest one kept
+    // before everything in it is committed and it starts over.
+    static constexpr int STREAM_MIN_SAMPLES = 16'000;
+    static constexpr int STREAM_MAX_SAMPLES = 320'000;
+
+    std::shared_ptr<WhisperContext> context() const;
+    // The resident model a recording of `n_samples` is routed to.
+    std::shared_ptr<WhisperContext> context_for(size_t n_samples);
+    void install(std::shared_ptr<WhisperContext> ctx, const WhisperModel& model);
+    bool start_load(const WhisperModel& model, bool activate);
 
     static bool is_hallucination(const std::string& text);
     void output_text(const std::string& text);
-    TranscriptionResult transcribe_and_output(const std::vector<float>& samples);
-    TranscriptionResult transcribe_chunked(const std::vector<float>& samples);
+    TranscriptionResult transcribe_and_output(const RecordingStore& recording, const MelSpectrogram* mel = nullptr);
+    bool find_speech(const RecordingStore& recording, SpeechMap& map);
+
+    // A range of packed positions in a SpeechMap.
+    struct Chunk {
+        size_t begin;
+        size_t end;
+    };
+    std::vector<Chunk> plan_chunks(const RecordingStore& recording, const SpeechMap& map);
+    TranscriptionResult transcribe_chunked(WhisperContext& ctx, const RecordingStore& recording, const SpeechMap& map);
+    TranscriptionResult transcribe_sequential(WhisperContext& ctx, const RecordingStore& recording);
 
     void start_continuous_monitor();
     void stop_continuous_monitor();
     void continuous_loop();
+    void streaming_loop();
+    std::string context_prompt() const;
+    void commit_words(const std::vector<std::string>& words);
 };
@@ -1,40 +1,141 @@
 #include "vad.h"
 #include <algorithm>
 
-std::vector<float> VoiceActivityDetector::process(const float* samples, size_t count, int sample_rate) {
-    if (!is_enabled) return {samples, samples + count};
+void VoiceActivityDetector::process(const float* samples, size_t count, int sample_rate) {
+    if (!is_enabled) {
+        emit(samples, count);
+        return;
+    }
 
-    active_sample_rate_ = sample_rate;
-    int frame_size = sample_rate * 30 / 1000;
-    std::vector<float> output;
-    size_t offset = 0;
-
-    while (offset < count) {
-        size_t end = std::min(offset + static_cast<size_t>(frame_size), count);
-        process_frame(samples + offset, end - offset, output);
-        offset = end;
+    if (sample_rate != active_sample_rate_) configure(sample_rate);
+
+    while (count > 0) {
+        // Whole frames straight from the input when nothing is pending.
+        if (frame_fill_ == 0 && count >= frame_size_) {
+            process_frame(samples, frame_size_);
+            samples += frame_size_;
+            count -= frame_size_;
+            continue;
+        }
+
+        size_t take = std::min(count, frame_size_ - frame_fill_);
+        std::copy(samples, samples + take, frame_.begin() + static_cast<std::ptrdiff_t>(frame_fill_));
+        frame_fill_ += take;
+        samples += take;
+        count -= take;
+        if (frame_fill_ == frame_size_) {
+            process_frame(frame_.data(), frame_size_);
+            frame_fill_ = 0;
+        }
     }
+}
 
-    return output;
+void VoiceActivityDetector::apply(const Settings& s) {
+    speech_threshold = s.vad_speech_threshold;
+    silence_threshold = s.vad_silence_threshold;
+    min_speech_duration_ms = s.vad_min_speech_ms;
+    min_silence_duration_ms = s.vad_min_silence_ms;
+    pre_speech_padding_ms = s.vad_pre_padding_ms;
+    post_speech_padding_ms = s.vad_post_padding_ms;
+    adaptive = s.vad_adaptive;
+    speech_ratio = s.vad_speech_ratio;
+    silence_ratio = s.vad_silence_ratio;
+    speech_score = s.vad_speech_score;
+    silence_score = s.vad_silence_score;
+    speech_probability = s.vad_speech_probability;
+    silence_probability = s.vad_silence_probability;
 }
 
 void VoiceActivityDetector::reset() {
     state = State::silence;
-    is_speaking = false;
+    is_speaking.store(false, std::memory_order_relaxed);
+    speech_sample_count_ = 0;
+    silence_sample_count_ = 0;
+    input_pos_ = 0;
+    output_pos_ = 0;
+    if (active_sample_rate_ > 0) configure(active_sample_rate_);
+}
+
+// Sizes every buffer for the worst case the state machine can reach at
+// this rate and these settings. Onset and trailing silence are resolved on
+// a later frame than the one that started them, so each holds at least two
+// frames and at most its minimum duration rounded up to whole frames.
+void VoiceActivityDetector::configure(int sample_rate) {
+    // The floor describes the room, not the recording, so it carries over
+    // between recordings and only starts again on a new stream.
+    if (sample_rate != active_sample_rate_) {
+        noise_.reset();
+        noise_floor_.store(0, std::memory_order_relaxed);
+    }
+
+    active_sample_rate_ = sample_rate;
+    frame_size_ = static_cast<size_t>(std::max(1, sample_rate * 30 / 1000));
+    if (frame_.size() != frame_size_) frame_.assign(frame_size_, 0.0f);
+    frame_fill_ = 0;
+
+    size_t pre = static_cast<size_t>(std::max(0, pre_speech_max_samples()));
+    if (pre_speech_buf_.capacity() != pre) pre_speech_buf_.resize(pre);
     pre_speech_buf_.clear();
+
+    auto frames_for = [this](int samples) {
+        size_t frames = static_cast<size_t>(std::max(0, samples)) / frame_size_ + 1;
+        return std::max<size_t>(frames, 2) * frame_size_;
+    };
     onset_buf_.clear();
+    onset_buf_.reserve(frames_for(min_speech_samples()));
     post_speech_buf_.clear();
-    speech_sample_count_ = 0;
-    silence_sample_count_ = 0;
+    post_speech_buf_.reserve(frames_for(min_silence_samples()));
+
+    if (backend == VadBackend::spectral) spectral_.configure(sample_rate, frame_size_);
+    if (silero_) silero_->reset(sample_rate);
 }
 
-void VoiceActivityDetector::process_frame(const float* frame, size_t len, std::vector<float>& output) {
-    float rms = compute_rms(frame, len);
+bool VoiceActivityDetector::load_silero(const std::string& model_path, bool background) {
+    if (!silero_) {
+        silero_ = std::make_unique<SileroVad>();
+        silero_->background = background;
+    }
+    return silero_->load(model_path);
+}
+
+void VoiceActivityDetector::process_frame(const float* frame, size_t len) {
+    bool speech;
+    bool silence;
+    if (use_silero()) {
+        float p = silero_->process(frame, len);
+        speech = p >= speech_probability;
+        silence = p < silence_probability;
+    } else {
+        const bool scored = backend == VadBackend::spectral;
+        float rms;
+        float score = 1.0f;
+        if (scored) {
+            auto f = spectral_.analyze(frame, len);
+            rms = f.rms;
+            score = f.score;
+        } else {
+            rms = compute_rms(frame, len);
+        }
+
+        float speech_at = speech_threshold;
+        float silence_at = silence_threshold;
+        if (adaptive) {
+            float floor = noise_.update(rms);
+            noise_floor_.store(floor, std::memory_order_relaxed);
+            if (noise_.ready()) {
+                speech_at = std::max(speech_at, floor * speech_ratio);
+                silence_at = std::min(std::max(silence_at, floor * silence_ratio), speech_at);
+            }
+        }
+        speech = rms >= speech_at && score >= speech_score;
+        silence = rms < silence_at || (scored && score < silence_score);
+    }
 
     switch (state) {
     case State::silence:
-        if (rms >= speech_threshold) {
+        if (speech) {
             state = State::speech_onset;
+            onset_start_ = input_pos_;
             speech_sample_count_ = static_cast<int>(len);
             onset_buf_.assign(frame, frame + len);
         } else {
@@ -43,15 +144,18 @@ void VoiceActivityDetector::process_frame(const float* frame, size_t len, std::v
         break;
 
     case State::speech_onset:
-        if (rms >= speech_threshold) {
+        if (speech) {
             speech_sample_count_ += static_cast<int>(len);
             onset_buf_.insert(onset_buf_.end(), frame, frame + len);
 
             if (speech_sample_count_ >= min_speech_samples()) {
                 state = State::speaking;
-                is_speaking = true;
-                output.insert(output.end(), pre_speech_buf_.begin(), pre_speech_buf_.end());
-                output.insert(output.end(), onset_buf_.begin(), onset_buf_.end());
+                is_speaking.store(true, std::memory_order_relaxed);
+                auto pre = pre_speech_buf_.spans();
+                emit(pre.first, pre.first_len);
+                emit(pre.second, pre.second_len);
+                publish(VadEvent::Type::speech_start, onset_start_, output_pos_);
+                emit(onset_buf_.data(), onset_buf_.size());
                 pre_speech_buf_.clear();
                 onset_buf_.clear();
             }
@@ -65,45 +169,41 @@ void VoiceActivityDetector::process_frame(const float* frame, size_t len, std::v
         break;
 
     case State::speaking:
-        if (rms < silence_threshold) {
+        if (silence) {
             state = State::speech_offset;
+            offset_start_ = input_pos_;
             silence_sample_count_ = static_cast<int>(len);
             post_speech_buf_.assign(frame, frame + len);
         } else {
-            output.insert(output.end(), frame, frame + len);
+            emit(frame, len);
         }
         break;
 
     case State::speech_offset:
-        if (rms < silence_threshold) {
+        if (silence) {
             silence_sample_count_ += static_cast<int>(len);
             post_speech_buf_.insert(post_speech_buf_.end(), frame, frame + len);
 
             if (silence_sample_count_ >= min_silence_samples()) {
                 size_t padding = std::min(static_cast<size_t>(post_speech_max_samples()), post_speech_buf_.size());
-                output.insert(output.end(), post_speech_buf_.begin(), post_speech_buf_.begin() + padding);
+                uint64_t speech_end = output_pos_;
+                emit(post_speech_buf_.data(), padding);
                 post_speech_buf_.clear();
                 silence_sample_count_ = 0;
                 state = State::silence;
-                is_speaking = false;
+                is_speaking.store(false, std::memory_order_relaxed);
+                publish(VadEvent::Type::speech_end, offset_start_, speech_end);
                 pre_speech_buf_.clear();
             }
         } else {
-            output.insert(output.end(), post_speech_buf_.begin(), post_speech_buf_.end());
-            output.insert(output.end(), frame, frame + len);
+            emit(post_speech_buf_.data(), post_speech_buf_.size());
+            emit(frame, len);
             post_speech_buf_.clear();
             silence_sample_count_ = 0;
             state = State::speaking;
         }
         break;
     }
-}
 
-void VoiceActivityDetector::append_to_pre_speech(const float* data, size_t len) {
-    pre_speech_buf_.insert(pre_speech_buf_.end(), data, data + len);
-    int max = pre_speech_max_samples();
-    if (static_cast<int>(pre_speech_buf_.size()) > max) {
-        pre_speech_buf_.erase(pre_speech_buf_.begin(),
-                              pre_speech_buf_.begin() + (pre_speech_buf_.size() - max));
-    }
+    input_pos_ += len;
 }
@@ -1,15 +1,33 @@
 #pragma once
 
+#include "settings.h"
+#include "silero_vad.h"
+#include "circular_buffer.h"
+#include "noise_floor.h"
+#include "spectral_vad.h"
+#include "simd.h"
+#include "vad_events.h"
+#include <atomic>
 #include <vector>
 #include <cmath>
+#include <functional>
+#include <memory>
+#include <string>
 
 class VoiceActivityDetector {
 public:
     enum class State { silence, speech_onset, speaking, speech_offset };
 
+    // Receives the samples worth keeping, in order, from inside process().
+    using Sink = std::function<void(const float* samples, size_t count)>;
+    // Receives speech start/end as they are decided, with offsets in samples
+    // at the VAD's input rate since reset().
+    using EventSink = std::function<void(const VadEvent& event)>;
+
     State state = State::silence;
-    bool is_speaking = false;
+    std::atomic<bool> is_speaking{false};
     bool is_enabled = true;
+    VadBackend backend = VadBackend::energy;
 
     float speech_threshold = 0.007f;
     float silence_threshold = 0.003f;
@@ -18,29 +36,97 @@ public:
     int pre_speech_padding_ms = 200;
     int post_speech_padding_ms = 300;
 
-    std::vector<float> process(const float* samples, size_t count, int sample_rate = 16000);
+    // Energy backend: track the noise floor and raise both thresholds to
+    // these multiples of it when the room is louder than they allow for.
+    // The absolute thresholds above stay as lower bounds.
+    bool adaptive = false;
+    float speech_ratio = 3.0f;
+    float silence_ratio = 1.8f;
+
+    // Spectral backend: on top of the energy thresholds, a frame must score
+    // at least speech_score to count as speech, and below silence_score
+    // counts as silence whatever its level.
+    float speech_score = 0.6f;
+    float silence_score = 0.4f;
+
+    // Silero backend: speech starts at or above the first probability and
+    // ends below the second.
+    float speech_probability = 0.5f;
+    float silence_probability = 0.35f;
+
+    Sink sink;
+    EventSink on_event;
+
+    // Copies thresholds, durations and padding from the settings. Whether
+    // the VAD is enabled and which backend runs are left to the caller.
+    void apply(const Settings& settings);
+
+    // Classifies audio in exact 30 ms frames (a partial frame waits for the
+    // next call) and passes speech plus its padding to `sink`. Buffers are
+    // sized from the settings on a rate change and in reset(); otherwise
+    // this never allocates.
+    void process(const float* samples, size_t count, int sample_rate = 16000);
     void reset();
 
+    // Sizes the buffers for `sample_rate` ahead of the first process() call,
+    // so that call does not allocate either.
+    void configure(int sample_rate);
+
+    // `background` scores on Silero's own thread (live capture); offline
+    // callers pass false to have every window scored inside process().
+    bool load_silero(const std::string& model_path, bool background = true);
+    // Null unless the Silero backend is loaded and selected.
+    const SileroVad* silero() const { return use_silero() ? silero_.get() : nullptr; }
+
+    // Latest noise floor estimate (RMS); 0 until the tracker has settled.
+    float noise_floor() const { return noise_floor_.load(std::memory_order_relaxed); }
+
 private:
-    int active_sample_rate_ = 16000;
-    std::vector<float> pre_speech_buf_;
+    int active_sample_rate_ = 0;
+    size_t frame_size_ = 0;
+    std::vector<float> frame_;
+    size_t frame_fill_ = 0;
+
+    // Silence kept ahead of an onset, the onset frames awaiting
+    // confirmation, and trailing silence awaiting the end of speech. The
+    // latter two are reserved up front and only ever cleared, never grown
+    // past their capacity.
+    CircularBuffer<float> pre_speech_buf_;
     std::vector<float> onset_buf_;
     std::vector<float> post_speech_buf_;
     int speech_sample_count_ = 0;
     int silence_sample_count_ = 0;
 
+    // Stream positions for events: samples classified and samples emitted
+    // since reset(), and where the pending onset / trailing silence began.
+    uint64_t input_pos_ = 0;
+    uint64_t output_pos_ = 0;
+    uint64_t onset_start_ = 0;
+    uint64_t offset_start_ = 0;
+    std::unique_ptr<SileroVad> silero_;
+    NoiseFloorTracker noise_;
+    SpectralAnalyzer spectral_;
+    std::atomic<float> noise_floor_{0};
+
+    bool use_silero() const { return backend == VadBackend::silero && silero_ && silero_->loaded(); }
+
     int pre_speech_max_samples() const { return pre_speech_padding_ms * active_sample_rate_ / 1000; }
     int post_speech_max_samples() const { return post_speech_padding_ms * active_sample_rate_ / 1000; }
     int min_speech_samples() const { return min_speech_duration_ms * active_sample_rate_ / 1000; }
     int min_silence_samples() const { return min_silence_duration_ms * active_sample_rate_ / 1000; }
 
-    void process_frame(const float* frame, size_t len, std::vector<float>& output);
-    void append_to_pre_speech(const float* data, size_t len);
+    void process_frame(const float* frame, size_t len);
+    void emit(const float* data, size_t len) {
+        output_pos_ += len;
+        if (len > 0 && sink) sink(data, len);
+    }
+    void publish(VadEvent::Type type, uint64_t input, uint64_t output) {
+        if (on_event) on_event(VadEvent{type, input, output});
+    }
+    void append_to_pre_speech(const float* data, size_t len) { pre_speech_buf_.push(data, len); }
 
     static float compute_rms(const float* data, size_t len) {
         if (len == 0) return 0;
-        float sum = 0;
-        for (size_t i = 0; i < len; ++i) sum += data[i] * data[i];
-        return std::sqrt(sum / static_cast<float>(len));
+        return std::sqrt(Simd::dot(data, data, len) / static_cast<float>(len));
     }
 };
@@ -0,0 +1,249 @@
+#include "vad_eval.h"
+#include "model_manager.h"
+#include "resampler.h"
+#include "settings.h"
+#include "vad.h"
+#include "wav_reader.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+namespace {
+
+constexpr int RATE = 16000;
+constexpr size_t FRAME = RATE * 30 / 1000;
+constexpr uint64_t OPEN = std::numeric_limits<uint64_t>::max();
+
+struct Interval {
+    uint64_t start;
+    uint64_t end;
+};
+
+// A speech segment as the VAD reported it: where it placed each edge, and
+// how far into the stream it was when it decided.
+struct Segment {
+    uint64_t start;
+    uint64_t end;
+    uint64_t start_decided;
+    uint64_t end_decided;
+};
+
+struct Score {
+    uint64_t tp = 0;
+    uint64_t fp = 0;
+    uint64_t fn = 0;
+    uint64_t frames = 0;
+    double ns = 0;
+    int labels = 0;
+    int missed = 0;
+    std::vector<double> onset_ms;
+    std::vector<double> offset_ms;
+
+    void add(const Score& o) {
+        tp += o.tp;
+        fp += o.fp;
+        fn += o.fn;
+        frames += o.frames;
+        ns += o.ns;
+        labels += o.labels;
+        missed += o.missed;
+        onset_ms.insert(onset_ms.end(), o.onset_ms.begin(), o.onset_ms.end());
+        offset_ms.insert(offset_ms.end(), o.offset_ms.begin(), o.offset_ms.end());
+    }
+};
+
+// Audacity label track export: "start<TAB>end<TAB>text" in seconds. Its
+// spectral-selection rows start with a backslash and are skipped.
+bool read_labels(const std::string& wav_path, std::vector<Interval>& out) {
+    std::string base = wav_path;
+    size_t dot = base.find_last_of('.');
+    size_t slash = base.find_last_of('/');
+    if (dot != std::string::npos && (slash == std::string::npos || dot > slash)) base.resize(dot);
+
+    for (const char* ext : {".txt", ".lab"}) {
+        std::ifstream f(base + ext);
+        if (!f) continue;
+
+        std::string line;
+        while (std::getline(f, line)) {
+            if (line.empty() || line[0] == '\\' || line[0] == '#') continue;
+            std::istringstream ss(line);
+            double s, e;
+            if (ss >> s >> e && e > s && s >= 0) {
+                out.push_back({static_cast<uint64_t>(s * RATE), static_cast<uint64_t>(e * RATE)});
+            }
+        }
+        std::sort(out.begin(), out.end(), [](const Interval& a, const Interval& b) { return a.start < b.start; });
+        return true;
+    }
+    return false;
+}
+
+void mark(std::vector<char>& frames, uint64_t start, uint64_t end) {
+    // A frame counts when its midpoint falls inside the interval.
+    size_t first = static_cast<size_t>((start + FRAME / 2) / FRAME);
+    size_t last = static_cast<size_t>(std::min<uint64_t>((end + FRAME / 2) / FRAME, frames.size()));
+    for (size_t i = first; i < last; ++i) frames[i] = 1;
+}
+
+double ms(uint64_t samples) { return static_cast<double>(samples) * 1000.0 / RATE; }
+
+// Onset latency runs from a label's start to the start event for it;
+// labels the VAD was already inside (a short gap it bridged) have none.
+// Offset latency runs from a label's end to the end event for the segment
+// covering it, and is skipped when that segment ran on into the next label.
+void score_latency(const std::vector<Interval>& labels, const std::vector<Segment>& segs, Score& score) {
+    for (size_t j = 0; j < labels.size(); ++j) {
+        const Interval& l = labels[j];
+        uint64_t next = j + 1 < labels.size() ? labels[j + 1].start : OPEN;
+
+        bool overlapped = false;
+        bool active_at_start = false;
+        const Segment* onset = nullptr;
+        const Segment* last = nullptr;
+        for (const auto& s : segs) {
+            if (s.start >= l.end) break;
+            if (s.end <= l.start) continue;
+            overlapped = true;
+            if (s.start_decided <= l.start) active_at_start = true;
+            if (!onset && s.start_decided > l.start) onset = &s;
+            last = &s;
+        }
+
+        ++score.labels;
+        if (!overlapped) {
+            ++score.missed;
+            continue;
+        }
+        if (onset && !active_at_start) score.onset_ms.push_back(ms(onset->start_decided - l.start));
+        if (last && last->end_decided != OPEN && last->end_decided >= l.end && last->end_decided < next) {
+            score.offset_ms.push_back(ms(last->end_decided - l.end));
+        }
+    }
+}
+
+bool evaluate(VadBackend kind, const std::string& silero_path, const Settings& settings,
+              const std::vector<float>& audio, const std::vector<Interval>& labels, Score& score) {
+    VoiceActivityDetector vad;
+    vad.apply(settings);
+    vad.backend = kind;
+    if (kind == VadBackend::silero && (silero_path.empty() || !vad.load_silero(silero_path, false))) return false;
+
+    // One frame per process() call, so every decision is made at the end of
+    // the frame being fed.
+    std::vector<Segment> segs;
+    uint64_t fed = 0;
+    vad.on_event = [&](const VadEvent& e) {
+        uint64_t decided = fed + FRAME;
+        if (e.type == VadEvent::Type::speech_start) {
+            segs.push_back({e.input_offset, OPEN, decided, OPEN});
+        } else if (!segs.empty()) {
+            segs.back().end = e.input_offset;
+            segs.back().end_decided = decided;
+        }
+    };
+    vad.configure(RATE);
+    vad.reset();
+
+    const size_t frames = audio.size() / FRAME;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < frames; ++i, fed += FRAME) {
+        vad.process(audio.data() + fed, FRAME, RATE);
+    }
+    score.ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    score.frames = frames;
+
+    std::vector<char> truth(frames, 0), pred(frames, 0);
+    for (const auto& l : labels) mark(truth, l.start, l.end);
+    for (const auto& s : segs) mark(pred, s.start, std::min<uint64_t>(s.end, fed));
+    for (size_t i = 0; i < frames; ++i) {
+        if (pred[i] && truth[i]) ++score.tp;
+        else if (pred[i]) ++score.fp;
+        else if (truth[i]) ++score.fn;
+    }
+
+    score_latency(labels, segs, score);
+    return true;
+}
+
+std::string latency(std::vector<double> v) {
+    if (v.empty()) return "-";
+    std::sort(v.begin(), v.end());
+    double mean = 0;
+    for (double x : v) mean += x;
+    mean /= static_cast<double>(v.size());
+    double p90 = v[std::min(v.size() - 1, v.size() * 9 / 10)];
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.0f / %.0f", mean, p90);
+    return buf;
+}
+
+void print_row(const char* name, const Score& s) {
+    double precision = s.tp + s.fp > 0 ? static_cast<double>(s.tp) / static_cast<double>(s.tp + s.fp) : 0;
+    double recall = s.tp + s.fn > 0 ? static_cast<double>(s.tp) / static_cast<double>(s.tp + s.fn) : 0;
+    double f1 = precision + recall > 0 ? 2 * precision * recall / (precision + recall) : 0;
+    double ns = s.frames > 0 ? s.ns / static_cast<double>(s.frames) : 0;
+    printf("  %-10s  %9.3f  %6.3f  %6.3f  %14s  %14s  %8.0f  %3d/%d\n", name, precision, recall, f1,
+           latency(s.onset_ms).c_str(), latency(s.offset_ms).c_str(), ns, s.missed, s.labels);
+}
+
+} // namespace
+
+int run_vad_eval(const std::vector<std::string>& wav_paths) {
+    Settings settings = Settings::load();
+    std::string silero_path = ModelManager::vad_model_path();
+    const VadBackend backends[] = { VadBackend::energy, VadBackend::spectral, VadBackend::silero };
+    Score totals[3];
+    bool have[3] = {};
+    int evaluated = 0;
+
+    printf("VAD evaluation (30 ms frames at 16 kHz, thresholds from settings)\n");
+    printf("Latency is mean / p90 in ms from the labelled edge to the VAD's decision.\n\n");
+    printf("  %-10s  %9s  %6s  %6s  %14s  %14s  %8s  %s\n",
+           "Backend", "Precision", "Recall", "F1", "Onset ms", "Offset ms", "ns/frame", "Missed");
+
+    for (const auto& path : wav_paths) {
+        std::vector<float> audio;
+        int rate = 0;
+        if (!read_wav(path, audio, rate)) {
+            fprintf(stderr, "[VadEval] Cannot read %s (16/24/32-bit PCM or float WAV expected)\n", path.c_str());
+            continue;
+        }
+        std::vector<Interval> labels;
+        if (!read_labels(path, labels)) {
+            fprintf(stderr, "[VadEval] No label file for %s\n", path.c_str());
+            continue;
+        }
+        if (rate != RATE) audio = Resampler(rate, RATE).resample(audio);
+
+        printf("\n%s (%.1f s, %zu labels)\n", path.c_str(), static_cast<double>(audio.size()) / RATE, labels.size());
+        for (int b = 0; b < 3; ++b) {
+            Score score;
+            if (!evaluate(backends[b], silero_path, settings, audio, labels, score)) {
+                printf("  %-10s  no model\n", vad_backend_name(backends[b]));
+                continue;
+            }
+            print_row(vad_backend_name(backends[b]), score);
+            totals[b].add(score);
+            have[b] = true;
+        }
+        ++evaluated;
+    }
+
+    if (evaluated == 0) {
+        fprintf(stderr, "[VadEval] Nothing to evaluate\n");
+        return 1;
+    }
+    if (evaluated > 1) {
+        printf("\nAll %d files\n", evaluated);
+        for (int b = 0; b < 3; ++b) {
+            if (have[b]) print_row(vad_backend_name(backends[b]), totals[b]);
+        }
+    }
+    printf("\nDone.\n");
+    return 0;
+}
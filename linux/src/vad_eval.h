@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Scores every VAD backend against hand-labelled recordings. Each WAV needs
+// a label file next to it with the same name and a .txt extension (.lab is
+// also accepted), holding one speech interval per line as
+// "start<TAB>end[<TAB>text]" in seconds: the format Audacity exports.
+//
+// Audio is brought to 16 kHz and fed in 30 ms frames as on the live path,
+// with the thresholds from the user's settings, and scored on frame-level
+// precision/recall, how long each onset and offset took to be decided,
+// and the per-frame cost.
+int run_vad_eval(const std::vector<std::string>& wav_paths);
@@ -0,0 +1,60 @@
+#include "vad_events.h"
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <cstdio>
+
+VadEventQueue::VadEventQueue() {
+    fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd_ < 0) perror("[VadEventQueue] eventfd");
+}
+
+VadEventQueue::~VadEventQueue() {
+    if (fd_ >= 0) close(fd_);
+}
+
+void VadEventQueue::push(const VadEvent& event) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) < CAPACITY) {
+        events_[head % CAPACITY] = event;
+        head_.store(head + 1, std::memory_order_release);
+    } else {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+    wake();
+}
+
+bool VadEventQueue::pop(VadEvent& out) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire)) return false;
+    out = events_[tail % CAPACITY];
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+void VadEventQueue::clear() {
+    tail_.store(head_.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+bool VadEventQueue::wait(int timeout_ms) {
+    if (tail_.load(std::memory_order_relaxed) != head_.load(std::memory_order_acquire)) return true;
+    if (fd_ < 0) {
+        usleep(static_cast<useconds_t>(timeout_ms) * 1000);
+        return false;
+    }
+
+    pollfd pfd{fd_, POLLIN, 0};
+    if (poll(&pfd, 1, timeout_ms) <= 0) return false;
+
+    uint64_t value;
+    ssize_t n = read(fd_, &value, sizeof(value));
+    (void)n;
+    return true;
+}
+
+void VadEventQueue::wake() {
+    if (fd_ < 0) return;
+    uint64_t one = 1;
+    ssize_t n = write(fd_, &one, sizeof(one));
+    (void)n;
+}
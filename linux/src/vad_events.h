@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Speech boundary reported by the VAD. Offsets count 16 kHz samples since
+// the recording started: `input` in the captured stream, `output` in the
+// audio the VAD kept (what the recording buffer holds).
+struct VadEvent {
+    enum class Type { speech_start, speech_end };
+
+    Type type = Type::speech_start;
+    uint64_t input_offset = 0;
+    uint64_t output_offset = 0;
+};
+
+// Single-producer/single-consumer queue of VAD events with an eventfd for
+// wakeups. The capture thread pushes without locking or allocating (the
+// eventfd write is one non-blocking syscall); a worker blocks in wait()
+// until an event arrives, wake() is called, or the timeout passes.
+class VadEventQueue {
+public:
+    static constexpr size_t CAPACITY = 64;
+
+    VadEventQueue();
+    ~VadEventQueue();
+
+    VadEventQueue(const VadEventQueue&) = delete;
+    VadEventQueue& operator=(const VadEventQueue&) = delete;
+
+    // Producer. Drops the event (and counts it) if the consumer is that far
+    // behind; the wakeup is still delivered.
+    void push(const VadEvent& event);
+
+    // Consumer.
+    bool pop(VadEvent& out);
+    void clear();
+
+    // Blocks until there may be something to pop or the timeout passes.
+    // Returns false on timeout.
+    bool wait(int timeout_ms);
+    // Wakes a waiting consumer without an event (shutdown, state changes).
+    void wake();
+
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    std::array<VadEvent, CAPACITY> events_{};
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+    std::atomic<uint64_t> dropped_{0};
+    int fd_ = -1;
+};
@@ -0,0 +1,74 @@
+#include "wav_reader.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+static uint16_t le16(const unsigned char* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+static uint32_t le32(const unsigned char* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8)
+         | (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+bool read_wav(const std::string& path, std::vector<float>& out, int& rate) {
+    std::ifstream f(path, std::ios::binary);
+    if (!f) return false;
+    std::vector<unsigned char> data((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    if (data.size() < 12 || std::memcmp(data.data(), "RIFF", 4) != 0 || std::memcmp(data.data() + 8, "WAVE", 4) != 0) {
+        return false;
+    }
+
+    int format = 0, channels = 0, bits = 0;
+    rate = 0;
+    const unsigned char* pcm = nullptr;
+    size_t pcm_bytes = 0;
+
+    for (size_t pos = 12; pos + 8 <= data.size();) {
+        const unsigned char* chunk = data.data() + pos;
+        size_t size = le32(chunk + 4);
+        size_t avail = std::min(size, data.size() - pos - 8);
+        const unsigned char* body = chunk + 8;
+
+        if (std::memcmp(chunk, "fmt ", 4) == 0 && avail >= 16) {
+            format = le16(body);
+            channels = le16(body + 2);
+            rate = static_cast<int>(le32(body + 4));
+            bits = le16(body + 14);
+            if (format == 0xFFFE && avail >= 26) format = le16(body + 24);
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            pcm = body;
+            pcm_bytes = avail;
+        }
+        pos += 8 + size + (size & 1);
+    }
+
+    bool is_float = format == 3 && bits == 32;
+    bool is_pcm = format == 1 && (bits == 16 || bits == 24 || bits == 32);
+    if (!pcm || channels < 1 || rate <= 0 || (!is_float && !is_pcm)) return false;
+
+    const size_t width = static_cast<size_t>(bits / 8);
+    const size_t frames = pcm_bytes / (width * static_cast<size_t>(channels));
+    out.resize(frames);
+    for (size_t i = 0; i < frames; ++i) {
+        float sum = 0;
+        for (int ch = 0; ch < channels; ++ch) {
+            const unsigned char* p = pcm + (i * static_cast<size_t>(channels) + static_cast<size_t>(ch)) * width;
+            float v;
+            if (is_float) {
+                std::memcpy(&v, p, sizeof(v));
+            } else if (bits == 16) {
+                v = static_cast<float>(static_cast<int16_t>(le16(p))) / 32768.0f;
+            } else if (bits == 24) {
+                int32_t x = p[0] | (p[1] << 8) | (p[2] << 16);
+                if (x & 0x800000) x -= 0x1000000;
+                v = static_cast<float>(x) / 8388608.0f;
+            } else {
+                v = static_cast<float>(static_cast<int32_t>(le32(p))) / 2147483648.0f;
+            }
+            sum += v;
+        }
+        out[i] = sum / static_cast<float>(channels);
+    }
+    return true;
+}
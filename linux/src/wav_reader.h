@@ -0,0 +1,9 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Reads a WAV file as mono float: 16/24/32-bit PCM or 32-bit float, plain
+// or WAVE_FORMAT_EXTENSIBLE, with channels averaged. The rate is returned
+// as found; callers resample.
+bool read_wav(const std::string& path, std::vector<float>& out, int& rate);
@@ -1,5 +1,6 @@
 #include "whisper_context.h"
 #include "whisper.h"
+#include <algorithm>
 #include <chrono>
 #include <stdexcept>
 #include <filesystem>
@@ -12,16 +13,66 @@ WhisperContext::WhisperContext(const std::string& model_path, const Settings& se
     cparams.use_gpu = settings.use_gpu;
     cparams.flash_attn = settings.flash_attention;
 
-    ctx_ = whisper_init_from_file_with_params(model_path.c_str(), cparams);
+    ctx_ = whisper_init_from_file_with_params_no_state(model_path.c_str(), cparams);
     if (!ctx_) throw std::runtime_error("Failed to load whisper model: " + model_path);
+    max_states_ = std::clamp(settings.whisper_states, 1, 8);
 
     model_name_ = std::filesystem::path(model_path).stem().string();
+    if (!LogMel::read_model_filters(model_path, mel_filters_)) {
+        fprintf(stderr, "[WhisperContext] Could not read mel filters from %s\n", model_path.c_str());
+    }
 }
 
 WhisperContext::~WhisperContext() {
+    for (auto* state : states_) whisper_free_state(state);
     if (ctx_) whisper_free(ctx_);
 }
 
+whisper_state* WhisperContext::acquire(int& jobs) {
+    std::unique_lock<std::mutex> lk(pool_mu_);
+    for (;;) {
+        if (!idle_.empty()) {
+            whisper_state* state = idle_.back();
+            idle_.pop_back();
+            jobs = ++busy_;
+            return state;
+        }
+        if (static_cast<int>(states_.size()) + creating_ < max_states_) {
+            // Creating a state allocates hundreds of MB; the slot is
+            // reserved so that release() and other callers are not held up.
+            ++creating_;
+            lk.unlock();
+            whisper_state* state = whisper_init_state(ctx_);
+            lk.lock();
+            --creating_;
+            if (state) {
+                states_.push_back(state);
+                jobs = ++busy_;
+                return state;
+            }
+            // Out of memory for another state: settle for the ones we have,
+            // but never below one, so a later call tries again. Waiters are
+            // woken since the slot they were waiting on will not come.
+            fprintf(stderr, "[WhisperContext] Could not create state %zu, keeping %zu\n",
+                    states_.size() + 1, states_.size());
+            max_states_ = std::max(1, static_cast<int>(states_.size()));
+            pool_cv_.notify_all();
+            if (states_.empty()) return nullptr;
+            continue;
+        }
+        pool_cv_.wait(lk);
+    }
+}
+
+void WhisperContext::release(whisper_state* state) {
+    {
+        std::lock_guard<std::mutex> lk(pool_mu_);
+        idle_.push_back(state);
+        --busy_;
+    }
+    pool_cv_.notify_one();
+}
+
 void WhisperContext::warmup() {
     fprintf(stderr, "[WhisperContext] Warming up model...\n");
     auto start = std::chrono::steady_clock::now();
@@ -32,17 +83,52 @@ void WhisperContext::warmup() {
     fprintf(stderr, "[WhisperContext] Warmup complete (%.0fms)\n", elapsed);
 }
 
+int WhisperContext::n_mels() const {
+    return whisper_model_n_mels(ctx_);
+}
+
+int WhisperContext::audio_ctx_for(size_t n_samples, const Settings& settings, bool tuned) {
+    if (!settings.dynamic_audio_ctx) return 0;
+    // One encoder frame per 20 ms, rounded up to a multiple of 64 so the
+    // encoder's matrices keep friendly shapes.
+    size_t ms = n_samples / 16 + static_cast<size_t>(std::max(0, settings.audio_ctx_margin_ms));
+    int ctx = static_cast<int>((ms + 19) / 20);
+    ctx = (ctx + 63) / 64 * 64;
+    ctx = std::max(ctx, tuned ? MIN_TUNED_AUDIO_CTX : std::max(MIN_TUNED_AUDIO_CTX, settings.audio_ctx_min));
+    return ctx >= FULL_AUDIO_CTX ? 0 : ctx;
+}
+
+bool WhisperContext::tuned_for_audio_ctx(const std::string& model_name) {
+    return model_name.find("acft") != std::string::npos;
+}
+
 TranscriptionResult WhisperContext::transcribe(const std::vector<float>& samples, const std::string* context_prompt) {
-    std::lock_guard<std::mutex> lk(mu_);
+    return run(&samples, nullptr, context_prompt);
+}
 
+TranscriptionResult WhisperContext::transcribe(const MelSpectrogram& mel, const std::string* context_prompt) {
+    return run(nullptr, &mel, context_prompt);
+}
+
+TranscriptionResult WhisperContext::run(const std::vector<float>* samples, const MelSpectrogram* mel,
+                                        const std::string* context_prompt) {
     auto start = std::chrono::steady_clock::now();
 
+    TranscriptionResult tr;
+    tr.audio_duration_ms = static_cast<double>(samples ? samples->size() : mel->n_samples) / 16.0;
+    tr.model_name = model_name_;
+
+    int jobs = 1;
+    whisper_state* state = acquire(jobs);
+    if (!state) return tr;
+
     auto params = whisper_full_default_params(
         settings_.strategy == SamplingStrategy::beam_search
             ? WHISPER_SAMPLING_BEAM_SEARCH
             : WHISPER_SAMPLING_GREEDY);
 
-    params.n_threads = settings_.resolved_thread_count();
+    // Jobs running side by side split the cores rather than each taking all.
+    params.n_threads = std::max(1, settings_.resolved_thread_count() / jobs);
     params.translate = settings_.translate;
     params.no_context = (context_prompt == nullptr) ? settings_.no_context : false;
     params.no_timestamps = settings_.no_timestamps;
@@ -62,6 +148,8 @@ TranscriptionResult WhisperContext::transcribe(const std::vector<float>& samples
     params.print_timestamps = false;
 
     params.language = settings_.language.c_str();
+    params.audio_ctx = audio_ctx_for(samples ? samples->size() : mel->n_samples, settings_,
+                                     tuned_for_audio_ctx(model_name_));
 
     const std::string* prompt = context_prompt;
     std::string fallback;
@@ -71,28 +159,31 @@ TranscriptionResult WhisperContext::transcribe(const std::vector<float>& samples
     }
     params.initial_prompt = prompt ? prompt->c_str() : nullptr;
 
-    int result = whisper_full(ctx_, params, samples.data(), static_cast<int>(samples.size()));
-
-    auto elapsed = std::chrono::duration<double, std::milli>(
-        std::chrono::steady_clock::now() - start).count();
-    double audio_ms = static_cast<double>(samples.size()) / 16.0;
-
-    TranscriptionResult tr;
-    tr.audio_duration_ms = audio_ms;
-    tr.transcription_time_ms = elapsed;
-    tr.model_name = model_name_;
-
-    if (result != 0) return tr;
+    int result;
+    if (samples) {
+        result = whisper_full_with_state(ctx_, state, params, samples->data(), static_cast<int>(samples->size()));
+    } else {
+        // With no samples whisper_full keeps the state's mel. Its n_len
+        // includes the 30 s of padding, so the audio length bounds the seek.
+        params.duration_ms = static_cast<int>(mel->n_samples / 16);
+        result = whisper_set_mel_with_state(ctx_, state, mel->data.data(), mel->n_len, mel->n_mel);
+        if (result == 0) result = whisper_full_with_state(ctx_, state, params, nullptr, 0);
+    }
 
-    int n_segments = whisper_full_n_segments(ctx_);
-    tr.segments.reserve(n_segments);
+    if (result == 0) {
+        int n_segments = whisper_full_n_segments_from_state(state);
+        tr.segments.reserve(n_segments);
 
-    for (int i = 0; i < n_segments; ++i) {
-        const char* text = whisper_full_get_segment_text(ctx_, i);
-        int64_t t0 = whisper_full_get_segment_t0(ctx_, i) * 10;
-        int64_t t1 = whisper_full_get_segment_t1(ctx_, i) * 10;
-        tr.segments.push_back({text ? text : "", t0, t1});
+        for (int i = 0; i < n_segments; ++i) {
+            const char* text = whisper_full_get_segment_text_from_state(state, i);
+            int64_t t0 = whisper_full_get_segment_t0_from_state(state, i) * 10;
+            int64_t t1 = whisper_full_get_segment_t1_from_state(state, i) * 10;
+            tr.segments.push_back({text ? text : "", t0, t1});
+        }
     }
+    release(state);
 
+    tr.transcription_time_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
     return tr;
 }
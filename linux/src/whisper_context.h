@@ -1,12 +1,21 @@
 #pragma once
 
 #include "transcription_result.h"
+#include "log_mel.h"
 #include "settings.h"
+#include <condition_variable>
 #include <string>
 #include <mutex>
+#include <vector>
 
 struct whisper_context;
+struct whisper_state;
 
+// Model weights loaded once, shared by a pool of up to `whisper_states`
+// decoding states. Each transcribe() borrows a state for the length of the
+// call, so that many calls run in parallel; further callers wait for one
+// to be returned. States are created on first demand, since each carries
+// its own KV cache and compute buffers.
 class WhisperContext {
 public:
     WhisperContext(const std::string& model_path, const Settings& settings);
@@ -17,10 +26,48 @@ public:
 
     void warmup();
     TranscriptionResult transcribe(const std::vector<float>& samples, const std::string* context_prompt = nullptr);
+    // Decodes from a spectrogram computed ahead of time (LogMel), skipping
+    // whisper's own mel pass.
+    TranscriptionResult transcribe(const MelSpectrogram& mel, const std::string* context_prompt = nullptr);
+
+    int n_mels() const;
+    // The filterbank from the model file, for LogMel; empty if unreadable.
+    const std::vector<float>& mel_filters() const { return mel_filters_; }
+    const std::string& model_name() const { return model_name_; }
+
+    // Encoder frames (audio_ctx) for `n_samples` of 16 kHz audio under the
+    // dynamic_audio_ctx settings, or 0 for whisper's full window. Models
+    // fine-tuned for short contexts go down to MIN_TUNED_AUDIO_CTX.
+    static int audio_ctx_for(size_t n_samples, const Settings& settings, bool tuned);
+    // FUTO's "acft" checkpoints are fine-tuned to work at any audio_ctx.
+    static bool tuned_for_audio_ctx(const std::string& model_name);
+
+    static constexpr int FULL_AUDIO_CTX = 1500;
+    static constexpr int MIN_TUNED_AUDIO_CTX = 64;
+
+    int max_states() const {
+        std::lock_guard<std::mutex> lk(pool_mu_);
+        return max_states_;
+    }
 
 private:
     whisper_context* ctx_;
     Settings settings_;
     std::string model_name_;
-    std::mutex mu_;
+    std::vector<float> mel_filters_;
+    int max_states_ = 1;
+
+    mutable std::mutex pool_mu_;
+    std::condition_variable pool_cv_;
+    std::vector<whisper_state*> states_;
+    std::vector<whisper_state*> idle_;
+    int busy_ = 0;
+    int creating_ = 0;  // states being created outside pool_mu_
+
+    // Returns null only if not even one state could be created. `jobs` is
+    // how many transcriptions are running, this one included.
+    whisper_state* acquire(int& jobs);
+    void release(whisper_state* state);
+    TranscriptionResult run(const std::vector<float>* samples, const MelSpectrogram* mel,
+                            const std::string* context_prompt);
 };
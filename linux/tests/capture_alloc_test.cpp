@@ -0,0 +1,151 @@
+// The whole capture path must not touch the heap once it is running: a
+// fake backend delivers frames to a prepared AudioEngine the way a real
+// one does, through format conversion, resampling, pre-roll, the VAD and
+// the ring push, and no allocation may happen on the delivering thread
+// after the first cycle. The drain thread is not counted; it writes the
+// recording store, which does allocate.
+//
+// Silero runs only with SPEAK_TEST_VAD_MODEL set to its model file. Its
+// scoring happens on its own thread, so what is checked here is the
+// capture side: cutting windows and queueing them.
+#include "audio_engine.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+static thread_local bool t_counting = false;
+static thread_local size_t t_allocations = 0;
+
+void* operator new(size_t size) {
+    if (t_counting) ++t_allocations;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+// Opens whatever spec it was made with and hands the callback to the test.
+class FakeCapture : public CaptureBackend {
+public:
+    explicit FakeCapture(CaptureSpec spec) : spec_(spec) {}
+
+    bool open(const std::string&, CaptureSpec& spec, int, Callback on_frames) override {
+        spec = spec_;
+        on_frames_ = std::move(on_frames);
+        return true;
+    }
+    void close() override { on_frames_ = nullptr; }
+    const char* name() const override { return "fake"; }
+    CaptureStats stats() const override { return {}; }
+
+    void deliver(const void* data, size_t frames) { on_frames_(data, frames); }
+
+private:
+    CaptureSpec spec_;
+    Callback on_frames_;
+};
+
+// Two seconds of a loud tone, then two of near-silence, in 20 ms frames at
+// the backend's rate and format; enough for onset, speaking and offset.
+class Source {
+public:
+    Source(CaptureSpec spec, int frame_ms)
+        : spec_(spec), frame_(spec.rate * static_cast<size_t>(frame_ms) / 1000),
+          f32_(frame_), s16_(frame_) {}
+
+    size_t cycle(FakeCapture& capture, VadEventQueue& events) {
+        size_t n_events = 0;
+        for (int half = 0; half < 2; ++half) {
+            float amp = half == 0 ? 0.3f : 0.0005f;
+            for (size_t done = 0; done < spec_.rate * 2; done += frame_) {
+                for (size_t i = 0; i < frame_; ++i, ++t_) {
+                    float v = amp * std::sin(2.0f * 3.14159265f * 440.0f * static_cast<float>(t_) / static_cast<float>(spec_.rate));
+                    f32_[i] = v;
+                    s16_[i] = static_cast<int16_t>(v * 32767.0f);
+                }
+                if (spec_.format == SampleFormat::f32) {
+                    capture.deliver(f32_.data(), frame_);
+                } else {
+                    capture.deliver(s16_.data(), frame_);
+                }
+                VadEvent ev;
+                while (events.pop(ev)) ++n_events;
+            }
+        }
+        return n_events;
+    }
+
+private:
+    CaptureSpec spec_;
+    size_t frame_;
+    size_t t_ = 0;
+    std::vector<float> f32_;
+    std::vector<int16_t> s16_;
+};
+
+static int run(const char* name, CaptureSpec spec, VadBackend vad, const char* silero = nullptr) {
+    AudioEngine engine;
+    engine.capture_format = CaptureFormat::float48k;
+    engine.realtime = false;
+    engine.vad().backend = vad;
+    if (silero && !engine.vad().load_silero(silero)) return 1;
+
+    auto backend = std::make_unique<FakeCapture>(spec);
+    FakeCapture& capture = *backend;
+    engine.prepare(std::move(backend), "");
+    if (!engine.is_prepared()) {
+        fprintf(stderr, "[capture_alloc_test] %s: engine did not start\n", name);
+        return 1;
+    }
+    Source source(spec, engine.frame_ms);
+    auto& events = engine.vad_events();
+
+    // Idle (pre-roll only), then the first cycle of a recording.
+    source.cycle(capture, events);
+    engine.start_recording();
+    source.cycle(capture, events);
+
+    t_allocations = 0;
+    t_counting = true;
+    size_t n_events = 0;
+    for (int i = 0; i < 5; ++i) n_events += source.cycle(capture, events);
+    t_counting = false;
+    auto first = engine.stop_recording();
+
+    // A second recording starts from the pre-roll and resets the
+    // resampler and VAD on the capture thread.
+    source.cycle(capture, events);
+    engine.start_recording();
+    t_counting = true;
+    for (int i = 0; i < 2; ++i) n_events += source.cycle(capture, events);
+    t_counting = false;
+    auto second = engine.stop_recording();
+    engine.release();
+
+    size_t allocations = t_allocations;
+    fprintf(stderr, "[capture_alloc_test] %s (%s): %zu allocations, %zu events, %zu + %zu samples kept\n",
+            name, engine.capture_path().describe().c_str(), allocations, n_events, first->size(), second->size());
+    if (allocations != 0) return 1;
+    if (n_events < 10 || first->size() == 0 || second->size() == 0) {
+        fprintf(stderr, "[capture_alloc_test] %s: VAD never switched state\n", name);
+        return 1;
+    }
+    return 0;
+}
+
+int main() {
+    int failed = 0;
+    failed += run("energy", {SampleFormat::f32, 48000}, VadBackend::energy);
+    failed += run("energy", {SampleFormat::f32, 44100}, VadBackend::energy);
+    failed += run("energy", {SampleFormat::s16, 16000}, VadBackend::energy);
+    failed += run("energy", {SampleFormat::f32, 16000}, VadBackend::energy);
+    failed += run("spectral", {SampleFormat::s16, 48000}, VadBackend::spectral);
+    failed += run("spectral", {SampleFormat::f32, 44100}, VadBackend::spectral);
+    if (const char* model = std::getenv("SPEAK_TEST_VAD_MODEL")) {
+        failed += run("silero", {SampleFormat::f32, 48000}, VadBackend::silero, model);
+    }
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,14 @@
+// WhisperContext without whisper.cpp, for tests of the model bookkeeping:
+// "loading" a model only records its name, so model files can be empty
+// files of the right size.
+#include "whisper_context.h"
+#include <filesystem>
+
+WhisperContext::WhisperContext(const std::string& model_path, const Settings& settings)
+    : ctx_(nullptr), settings_(settings) {
+    model_name_ = std::filesystem::path(model_path).stem().string();
+}
+
+WhisperContext::~WhisperContext() = default;
+
+void WhisperContext::warmup() {}
@@ -0,0 +1,140 @@
+// LogMel against whisper.cpp's own mel pass: reference() below follows
+// log_mel_spectrogram() in whisper.cpp step for step (padding, framing,
+// the frames it computes, double accumulation, normalisation), with a
+// double-precision DFT in place of its FFT. Audio is fed to LogMel in
+// uneven pieces, as the drain thread does. With SPEAK_TEST_MODEL set to
+// a ggml model file, the filterbank is read from it and the built-in
+// Slaney filterbank is checked against it as well.
+#include "log_mel.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+static constexpr double PI = 3.14159265358979323846;
+
+static std::vector<float> reference(const std::vector<float>& samples, int n_mel, const std::vector<float>& filters) {
+    const int frame_size = static_cast<int>(LogMel::N_FFT);
+    const int frame_step = static_cast<int>(LogMel::HOP);
+    const int n_fft = static_cast<int>(LogMel::BINS);
+    const int n_samples = static_cast<int>(samples.size());
+
+    const int stage_1_pad = 16000 * 30;
+    const int stage_2_pad = frame_size / 2;
+    std::vector<float> padded(static_cast<size_t>(n_samples + stage_1_pad + stage_2_pad * 2), 0.0f);
+    std::copy(samples.begin(), samples.end(), padded.begin() + stage_2_pad);
+    std::reverse_copy(samples.begin() + 1, samples.begin() + 1 + stage_2_pad, padded.begin());
+
+    const int n_len = static_cast<int>(padded.size() - frame_size) / frame_step;
+    std::vector<float> mel(static_cast<size_t>(n_mel) * n_len);
+
+    std::vector<double> hann(frame_size);
+    for (int i = 0; i < frame_size; ++i) hann[i] = 0.5 * (1.0 - std::cos(2.0 * PI * i / frame_size));
+
+    // whisper passes n_samples + stage_2_pad as the length to its workers.
+    const int n_in = n_samples + stage_2_pad;
+    std::vector<double> in(frame_size), power(n_fft);
+    int i = 0;
+    for (; i < std::min(n_in / frame_step + 1, n_len); ++i) {
+        const int offset = i * frame_step;
+        std::fill(in.begin(), in.end(), 0.0);
+        for (int j = 0; j < std::min(frame_size, n_in - offset); ++j) in[j] = hann[j] * padded[offset + j];
+
+        for (int k = 0; k < n_fft; ++k) {
+            double re = 0, im = 0;
+            for (int n = 0; n < frame_size; ++n) {
+                double a = 2.0 * PI * static_cast<double>((k * n) % frame_size) / frame_size;
+                re += in[n] * std::cos(a);
+                im -= in[n] * std::sin(a);
+            }
+            power[k] = re * re + im * im;
+        }
+
+        for (int j = 0; j < n_mel; ++j) {
+            double sum = 0;
+            for (int k = 0; k < n_fft; ++k) sum += power[k] * filters[static_cast<size_t>(j) * n_fft + k];
+            mel[static_cast<size_t>(j) * n_len + i] = static_cast<float>(std::log10(std::max(sum, 1e-10)));
+        }
+    }
+    for (; i < n_len; ++i) {
+        for (int j = 0; j < n_mel; ++j) mel[static_cast<size_t>(j) * n_len + i] = -10.0f;
+    }
+
+    double mmax = -1e20;
+    for (float v : mel) mmax = std::max(mmax, static_cast<double>(v));
+    mmax -= 8.0;
+    for (float& v : mel) v = static_cast<float>((std::max(static_cast<double>(v), mmax) + 4.0) / 4.0);
+    return mel;
+}
+
+// A tone sweeping up through the band over a little noise, so every
+// filter sees energy somewhere.
+static std::vector<float> test_audio(size_t n) {
+    std::vector<float> out(n);
+    uint32_t seed = 1;
+    double phase = 0;
+    for (size_t i = 0; i < n; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        double noise = (static_cast<double>(seed >> 8) / 16777216.0 - 0.5) * 0.01;
+        phase += 2.0 * PI * (100.0 + 7900.0 * static_cast<double>(i) / static_cast<double>(n)) / 16000.0;
+        out[i] = static_cast<float>(0.4 * std::sin(phase) + noise);
+    }
+    return out;
+}
+
+static int check(size_t n, int n_mel, const std::vector<float>* filters) {
+    LogMel mel;
+    mel.configure(n_mel, 16000 * 60, filters);
+    auto audio = test_audio(n);
+    static const size_t pieces[] = {1, 159, 160, 401, 4096, 777};
+    for (size_t off = 0, p = 0; off < n; ++p) {
+        size_t take = std::min(pieces[p % 6], n - off);
+        mel.append(audio.data() + off, take);
+        off += take;
+    }
+
+    MelSpectrogram out;
+    if (!mel.finish(out)) {
+        fprintf(stderr, "[log_mel_test] %zu samples: finish() failed\n", n);
+        return 1;
+    }
+    auto ref = reference(audio, n_mel, mel.filters());
+    if (out.data.size() != ref.size()) {
+        fprintf(stderr, "[log_mel_test] %zu samples: %zu values, whisper has %zu\n", n, out.data.size(), ref.size());
+        return 1;
+    }
+    double worst = 0;
+    for (size_t i = 0; i < ref.size(); ++i) worst = std::max(worst, std::fabs(static_cast<double>(out.data[i] - ref[i])));
+    fprintf(stderr, "[log_mel_test] %zu samples, %d mels: max difference %g\n", n, n_mel, worst);
+    return worst < 1e-3 ? 0 : 1;
+}
+
+int main() {
+    int failed = 0;
+    // 31800 and 47800 end with a frame starting exactly at the end of the
+    // padded audio.
+    for (size_t n : {16000u, 31800u, 47800u, 48123u}) {
+        failed += check(n, 80, nullptr);
+        failed += check(n, 128, nullptr);
+    }
+
+    if (const char* model = std::getenv("SPEAK_TEST_MODEL")) {
+        std::vector<float> filters;
+        if (!LogMel::read_model_filters(model, filters)) {
+            fprintf(stderr, "[log_mel_test] Could not read filters from %s\n", model);
+            return EXIT_FAILURE;
+        }
+        int n_mel = static_cast<int>(filters.size() / LogMel::BINS);
+        LogMel slaney;
+        slaney.configure(n_mel, 0);
+        double worst = 0;
+        for (size_t i = 0; i < filters.size(); ++i) {
+            worst = std::max(worst, std::fabs(static_cast<double>(slaney.filters()[i] - filters[i])));
+        }
+        fprintf(stderr, "[log_mel_test] Slaney vs %s filters: max difference %g\n", model, worst);
+        if (worst > 1e-5) ++failed;
+        failed += check(48123, n_mel, &filters);
+    }
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
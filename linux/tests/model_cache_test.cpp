@@ -0,0 +1,94 @@
+// Switching to a model that is already resident must move the selection
+// and the pin with it, so that a later preload is measured against, and
+// evicts around, the model actually in use. Follows the steps the
+// pipeline's start_load() takes, over sparse model files in a scratch
+// XDG directory.
+#include "model_cache.h"
+#include "model_manager.h"
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+static int failures = 0;
+
+static void expect(bool ok, const char* what) {
+    if (!ok) {
+        fprintf(stderr, "[model_cache_test] FAILED: %s\n", what);
+        ++failures;
+    }
+}
+
+static void make_model(const fs::path& dir, const std::string& id, int mb) {
+    fs::path p = dir / (id + ".bin");
+    std::ofstream(p).close();
+    fs::resize_file(p, static_cast<uintmax_t>(mb) * 1000000);
+}
+
+static const WhisperModel* find(const ModelManager& models, const std::string& id) {
+    for (auto& m : models.available()) {
+        if (m.id == id) return &m;
+    }
+    return nullptr;
+}
+
+static bool pinned(const ModelCache& cache, const std::string& id) {
+    for (auto& e : cache.entries()) {
+        if (e.model.id == id) return e.pinned;
+    }
+    return false;
+}
+
+int main() {
+    fs::path root = fs::temp_directory_path() / ("speak-model-cache-test-" + std::to_string(::getpid()));
+    fs::remove_all(root);
+    setenv("XDG_DATA_HOME", (root / "data").c_str(), 1);
+    setenv("XDG_CONFIG_HOME", (root / "config").c_str(), 1);
+    fs::create_directories(ModelManager::models_directory());
+    make_model(ModelManager::models_directory(), "ggml-tiny", 75);
+    make_model(ModelManager::models_directory(), "ggml-base", 140);
+    make_model(ModelManager::models_directory(), "ggml-small", 100);
+
+    ModelManager models;
+    ModelCache cache;
+    cache.budget_mb = 300;
+    Settings settings;
+    const WhisperModel tiny = *find(models, "ggml-tiny");
+    const WhisperModel base = *find(models, "ggml-base");
+    const WhisperModel small = *find(models, "ggml-small");
+
+    // Start on tiny, and preload base next to it.
+    cache.load(tiny, settings, true);
+    models.select(tiny.id);
+    cache.load(base, settings, false);
+
+    // Switch to base, which is resident: no load, just the bookkeeping.
+    expect(cache.get(base.id) != nullptr, "base is resident after preloading");
+    cache.pin(base.id);
+    models.select(base.id);
+    expect(models.current() && models.current()->id == base.id, "current() follows the switch");
+    expect(models.saved_or_first() && models.saved_or_first()->id == base.id, "the switch is saved");
+    expect(pinned(cache, base.id) && !pinned(cache, tiny.id), "the pin follows the switch");
+
+    // Preload small: base (140) + small (100) is under budget, and the
+    // 315 MB total then has tiny, no longer in use, evicted rather than base.
+    expect(cache.fits(small), "small fits next to the pinned base");
+    cache.load(small, settings, false);
+    expect(cache.get(base.id) != nullptr, "base stays resident");
+    expect(cache.get(small.id) != nullptr, "small is resident");
+    expect(cache.get(tiny.id) == nullptr, "tiny is evicted");
+    expect(cache.memory_mb() <= static_cast<double>(cache.budget_mb), "the cache is within budget");
+
+    // The selection is kept by id across a rescan.
+    models.scan();
+    expect(models.current() && models.current()->id == base.id, "current() survives a rescan");
+
+    cache.clear();
+    fs::remove_all(root);
+    if (failures == 0) fprintf(stderr, "[model_cache_test] ok\n");
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
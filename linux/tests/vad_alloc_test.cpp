@@ -0,0 +1,80 @@
+// The capture path must not touch the heap once it is running: feeds the
+// VAD speech/silence cycles through a sink and checks that no allocation
+// happens after the first cycle. capture_alloc_test.cpp covers the VAD
+// inside the engine's capture path.
+#include "vad.h"
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+static std::atomic<bool> g_counting{false};
+static std::atomic<size_t> g_allocations{0};
+
+void* operator new(size_t size) {
+    if (g_counting.load(std::memory_order_relaxed)) g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+static constexpr int RATE = 16000;
+static constexpr size_t FRAME = 4096;
+
+// Two seconds of a loud tone, then two of near-silence, in capture-sized
+// frames; enough to go through onset, speaking, offset and back.
+static void feed_cycle(VoiceActivityDetector& vad, std::vector<float>& frame, size_t& t) {
+    for (int half = 0; half < 2; ++half) {
+        float amp = half == 0 ? 0.3f : 0.0005f;
+        for (size_t n = 0; n < static_cast<size_t>(2 * RATE); n += FRAME) {
+            for (size_t i = 0; i < FRAME; ++i, ++t) {
+                frame[i] = amp * std::sin(2.0f * 3.14159265f * 440.0f * static_cast<float>(t) / RATE);
+            }
+            vad.process(frame.data(), FRAME, RATE);
+        }
+    }
+}
+
+static int run(VadBackend backend, const char* name) {
+    VoiceActivityDetector vad;
+    vad.backend = backend;
+    vad.adaptive = true;
+
+    std::vector<float> recorded(static_cast<size_t>(RATE) * 60);
+    size_t recorded_n = 0, events = 0;
+    vad.sink = [&](const float* samples, size_t count) {
+        for (size_t i = 0; i < count && recorded_n < recorded.size(); ++i) recorded[recorded_n++] = samples[i];
+    };
+    vad.on_event = [&](const VadEvent&) { ++events; };
+    vad.configure(RATE);
+
+    std::vector<float> frame(FRAME);
+    size_t t = 0;
+    feed_cycle(vad, frame, t);
+
+    g_allocations = 0;
+    g_counting = true;
+    for (int i = 0; i < 5; ++i) feed_cycle(vad, frame, t);
+    g_counting = false;
+
+    size_t allocations = g_allocations;
+    fprintf(stderr, "[vad_alloc_test] %s: %zu allocations, %zu events, %zu samples kept\n",
+            name, allocations, events, recorded_n);
+    if (allocations != 0) return 1;
+    if (events < 10 || recorded_n == 0) {
+        fprintf(stderr, "[vad_alloc_test] %s: VAD never switched state\n", name);
+        return 1;
+    }
+    return 0;
+}
+
+int main() {
+    int failed = 0;
+    failed += run(VadBackend::energy, "energy");
+    failed += run(VadBackend::spectral, "spectral");
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}